@@ -1,4 +1,4 @@
-FIND_SOURCES=find ./frontend/ ./pjmsg_topic ./pjmsg_mcap/ -iname "*.h" -or -iname "*.cpp" | grep -v 3rdparty
+FIND_SOURCES=find ./frontend/ ./pjmsg_topic ./pjmsg_mcap/ ./pjmsg_shm/ -iname "*.h" -or -iname "*.cpp" | grep -v 3rdparty
 
 # 0523591 = releases/cpp/v1.4.2 + visibility patch
 MCAP_SHA=05235919810ee02bfc68d4949c8b304da8b1376b
@@ -10,16 +10,26 @@
 #pragma once
 
 #include <memory>
-#include <shared_mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include <functional>
 #include <typeinfo>
 #include <typeindex>
 
 #include <ariles2/ariles.h>
 
-#define INTROMETRY_PUBLIC __attribute__((visibility("default")))
-#define INTROMETRY_HIDDEN __attribute__((visibility("hidden")))
+#include "../clock.h"
+#include "../sample.h"
+#include "../sink.h"
+#include "../statistics.h"
+#include "../thread.h"
 
 
 namespace intrometry::backend
@@ -38,7 +48,19 @@ namespace intrometry::backend
     std::string getRandomId(const std::size_t length);
     std::string normalizeId(const std::string &input_id);
 
+    /**
+     * Apply parameters to the calling thread.
+     * @return description of settings that could not be applied, empty on success
+     */
+    std::string configureThread(const ThreadParameters &parameters);
 
+
+    /**
+     * Wakes up the sink thread at absolute deadlines (timerfd) while data is
+     * being written, and puts it to sleep on an eventfd when idle: the first
+     * notify() after an idle step wakes the thread up, all other notify()
+     * calls are a fence and a relaxed load.
+     */
     class INTROMETRY_HIDDEN RateTimer
     {
     protected:
@@ -48,16 +70,408 @@ namespace intrometry::backend
         const std::unique_ptr<Implementation> pimpl_;
 
     public:
-        explicit RateTimer(const std::size_t rate);
+        /**
+         * @param[in] rate steps per second
+         * @param[in] max_idle_steps maximal number of steps skipped in idle
+         * state, 0 -- unlimited, 1 -- idling is disabled.
+         */
+        explicit RateTimer(const std::size_t rate, const std::size_t max_idle_steps = 1);
         ~RateTimer();
         [[nodiscard]] bool valid() const;
         void start();
-        void step();
+        /// @return number of skipped steps, steps skipped in idle state are not counted
+        std::size_t step();
+        /// Signal that there is data to process, called by writers
+        void notify();
+        /// Wake up and return immediately from all subsequent step() calls
+        void interrupt();
+    };
+
+
+    /**
+     * Process-wide pool of threads shared by sinks: each sink registers a
+     * task, which is executed at the sink rate by one of the threads, tasks
+     * are ordered by deadlines. Scheduling of a task follows RateTimer: idle
+     * tasks are not executed until notify(). Writers never lock the service:
+     * notify() marks an idle task and signals an eventfd, the task is
+     * requeued by a worker thread.
+     */
+    class INTROMETRY_HIDDEN FlushService
+    {
+    public:
+        class Task
+        {
+            friend class FlushService;
+
+        public:
+            /// the argument is the number of skipped steps
+            using Function = std::function<void(std::size_t)>;
+            using TimePoint = std::chrono::steady_clock::time_point;
+
+        protected:
+            const std::chrono::nanoseconds step_;  // NOLINT
+            const std::size_t max_idle_steps_;    // NOLINT
+            const Function function_;              // NOLINT
+
+            std::atomic<bool> pending_;
+            std::atomic<bool> sleeping_;
+            // set by notify() when the task must be requeued
+            std::atomic<bool> woken_;
+
+            // set by FlushService::add()
+            FlushService *service_;
+
+            // protected by the service mutex
+            std::multimap<TimePoint, Task *>::iterator position_;
+            TimePoint deadline_;
+            std::size_t skipped_steps_;
+            bool active_;
+            bool queued_;
+            bool running_;
+
+        public:
+            /// @param[in] rate, max_idle_steps see RateTimer
+            Task(const std::size_t rate, const std::size_t max_idle_steps, Function function);
+            [[nodiscard]] bool valid() const;
+            /// Signal that there is data to process, called by writers
+            void notify();
+        };
+
+    protected:
+        std::mutex mutex_;
+        // wakes up worker threads, semaphore mode: each signal wakes up one thread
+        int event_fd_;
+        // signalled when a task is finished
+        std::condition_variable finished_;
+        std::multimap<Task::TimePoint, Task *> queue_;
+        // all active tasks, including idle tasks, which are not queued
+        std::vector<Task *> tasks_;
+        std::vector<std::thread> threads_;
+        std::string thread_errors_;
+        std::size_t started_;
+        bool stop_;
+
+    protected:
+        void spin(const ThreadParameters &thread_parameters);
+        /// Put task to the queue after execution, requires lock
+        void schedule(Task &task);
+        /// Queue tasks woken up by notify(), requires lock
+        void requeue();
+        /// Lock-free and allocation-free, called by writers
+        void wake(Task &task);
+        void signal(const uint64_t count = 1) const;
+        /// Wait until deadline or signal(), must be called without lock
+        void wait(const Task::TimePoint &deadline) const;
+
+    public:
+        FlushService(const std::size_t threads, const ThreadParameters &thread_parameters);
+        ~FlushService();
+
+        FlushService(const FlushService &) = delete;
+        FlushService &operator=(const FlushService &) = delete;
+
+        /**
+         * Get the service, which is created on the first call and destroyed
+         * with the last reference: parameters are ignored if it exists.
+         */
+        static std::shared_ptr<FlushService> get(const std::size_t threads, const ThreadParameters &thread_parameters);
+
+        /// Parameters of worker threads that could not be applied, empty on success
+        [[nodiscard]] std::string getThreadErrors();
+
+        /// Start executing the task (immediately)
+        void add(Task &task);
+        /// Stop executing the task, waits for completion of the current execution
+        void remove(Task &task);
+    };
+
+
+    /**
+     * Runtime part of intrometry::Clock: ticks() is called on writes,
+     * toNanoseconds() by sink threads. Anchors are protected by a sequence
+     * lock, so that conversion never blocks re-anchoring.
+     */
+    class INTROMETRY_HIDDEN Clock
+    {
+    protected:
+        const intrometry::Clock parameters_;  // NOLINT
+
+        std::atomic<uint64_t> sequence_;
+        std::atomic<uint64_t> anchor_ticks_;
+        std::atomic<uint64_t> anchor_nanoseconds_;
+        std::atomic<double> nanoseconds_per_tick_;
+
+        // calibration origin, accessed by anchor() only
+        uint64_t origin_ticks_;
+        uint64_t origin_nanoseconds_;
+
+    protected:
+        /// simultaneous reading of ticks and system time
+        void read(uint64_t &ticks, uint64_t &nanoseconds) const;
+
+    public:
+        explicit Clock(const intrometry::Clock &parameters = intrometry::Clock());
+
+        /// Clock reading to be converted with toNanoseconds()
+        [[nodiscard]] uint64_t ticks() const;
+        /// Nanoseconds since epoch
+        [[nodiscard]] uint64_t toNanoseconds(const uint64_t ticks) const;
+
+        [[nodiscard]] uint64_t now() const
+        {
+            return (toNanoseconds(ticks()));
+        }
+
+        /// true if ticks() differ from nanoseconds since epoch
+        [[nodiscard]] bool raw() const
+        {
+            return (intrometry::Clock::Type::TSC == parameters_.type_
+                    or intrometry::Clock::Type::MONOTONIC_COARSE == parameters_.type_);
+        }
+
+        /// Re-anchor to the system clock, must be called periodically by a single thread
+        void anchor();
+    };
+
+
+    /// Source counters, producer and consumer counters are kept in separate cache lines.
+    class INTROMETRY_HIDDEN SourceCounters
+    {
+    public:
+        alignas(64) std::atomic<uint64_t> accepted_;
+        std::atomic<uint64_t> dropped_busy_;
+        std::atomic<uint64_t> dropped_full_;
+        std::atomic<uint64_t> overwritten_;
+
+        alignas(64) std::atomic<uint64_t> flushed_;
+        std::atomic<uint64_t> flush_busy_;
+        std::atomic<uint64_t> bytes_;
+
+    public:
+        SourceCounters();
+        void get(SourceStatistics &statistics) const;
+    };
+
+
+    class INTROMETRY_HIDDEN SinkCounters
+    {
+    public:
+        alignas(64) std::atomic<uint64_t> unassigned_;
+
+        alignas(64) std::atomic<uint64_t> flush_ticks_;
+        std::atomic<uint64_t> flush_overruns_;
+        std::atomic<uint64_t> io_stalls_;
+        std::atomic<uint64_t> unsubscribed_;
+
+        // state of the sink thread
+        std::atomic<int64_t> thread_cpu_;
+        std::atomic<int64_t> thread_policy_;
+        std::atomic<int64_t> thread_nice_;
+        std::atomic<uint64_t> thread_errors_;
+
+    public:
+        SinkCounters();
+        void get(SinkStatistics &statistics) const;
+        /// Sample state of the calling thread
+        void sampleThread();
+    };
+
+
+    inline void increment(std::atomic<uint64_t> &counter, const uint64_t value = 1)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+
+    /**
+     * Detects structure changes of a source between writes: structure of
+     * persistent sources is assumed to be preserved, only the number of
+     * names is checked, names of other sources are fingerprinted.
+     */
+    class StructureTracker
+    {
+    protected:
+        std::size_t size_ = 0;
+        uint64_t hash_ = 0;
+
+    public:
+        /// @return true if names have changed
+        bool update(const std::vector<std::string> &names, const bool persistent_structure)
+        {
+            bool names_changed = (size_ != names.size());
+            size_ = names.size();
+            if (persistent_structure)
+            {
+                // the fingerprint is not maintained
+                hash_ = 0;
+            }
+            else
+            {
+                const uint64_t hash = hashNames(names);
+                names_changed = (names_changed or hash_ != hash);
+                hash_ = hash;
+            }
+            return (names_changed);
+        }
+    };
+
+
+    /**
+     * Copy a sample to a namevalue2 container of a backend, which must be
+     * finalized afterwards as if it was filled by the namevalue2 writer.
+     * Names are copied only when the sample version or size changes, the
+     * container must keep names otherwise.
+     *
+     * @param[in,out] version version of the previously copied sample
+     * @return true if names have changed
+     */
+    template <class t_Container>
+    bool copySample(t_Container &container, const Sample &sample, uint64_t &version)
+    {
+        const bool names_changed = (version != sample.version_ or container.size() != sample.size());
+        version = sample.version_;
+
+        if (names_changed)
+        {
+            container.resize(sample.size());
+            for (std::size_t i = 0; i < sample.size(); ++i)
+            {
+                container.name(i) = sample.names_[i];
+            }
+        }
+        for (std::size_t i = 0; i < sample.size(); ++i)
+        {
+            container.value(i) = sample.values_[i];
+        }
+
+        return (names_changed);
+    }
+
+
+    /**
+     * Epoch based reclamation of shared data: readers register in one of
+     * two sets of sharded counters selected by the current epoch parity,
+     * synchronize() waits for all readers that may have observed old data.
+     * Readers never block each other and never block on writers.
+     */
+    class INTROMETRY_HIDDEN EpochDomain
+    {
+    protected:
+        static constexpr std::size_t shards_number_ = 16;
+
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> readers_[2];
+        };
+
+    protected:
+        Shard shards_[shards_number_];
+        std::atomic<std::size_t> epoch_;
+
+    public:
+        class ReadGuard
+        {
+        protected:
+            std::atomic<uint64_t> &readers_;
+
+        public:
+            explicit ReadGuard(EpochDomain &domain)
+              : readers_(domain.shards_[getShard()].readers_[domain.epoch_.load(std::memory_order_acquire) & 1])
+            {
+                // must be ordered with respect to the subsequent load of protected data
+                readers_.fetch_add(1, std::memory_order_seq_cst);
+            }
+
+            ~ReadGuard()
+            {
+                readers_.fetch_sub(1, std::memory_order_release);
+            }
+
+            ReadGuard(const ReadGuard &) = delete;
+            ReadGuard &operator=(const ReadGuard &) = delete;
+        };
+
+    protected:
+        static std::size_t getShard();
+        void wait(const std::size_t parity) const;
+
+    public:
+        EpochDomain();
+
+        /// Wait until data unpublished before this call is not referenced by readers, must not be called concurrently.
+        void synchronize();
+    };
+
+
+    /**
+     * Windowed aggregation of flattened values: writes are folded into
+     * running min / max / sum accumulators. Windows are double buffered, so
+     * that the consumer takes them with a pointer swap. Calls of fold() and
+     * swap() must be synchronized by the caller.
+     */
+    class INTROMETRY_HIDDEN Aggregator
+    {
+    public:
+        class Window
+        {
+        public:
+            std::vector<double> min_;
+            std::vector<double> max_;
+            std::vector<double> sum_;
+            uint64_t count_ = 0;
+        };
+
+        /// suffixes of aggregated series: min, max, mean
+        static constexpr std::array<const char *, 3> SUFFIXES = { "_min", "_max", "_mean" };
+
+    protected:
+        std::array<Window, 2> windows_;
+        Window *in_;
+        Window *out_;
+
+    public:
+        Aggregator();
+
+        /// Producer: fold values, the window is restarted if the number of values changes
+        void fold(const std::vector<double> &values);
+
+        /// Consumer: take the current window, returns false if it is empty
+        bool swap();
+
+        /// Consumer: window taken by swap()
+        [[nodiscard]] const Window &window() const
+        {
+            return (*out_);
+        }
+
+        /**
+         * Consumer: write min, max, and mean of the taken window to
+         * consecutive blocks of the output, which must have 3x size.
+         */
+        template <class t_Output>
+        void get(t_Output &&output) const
+        {
+            const std::size_t size = out_->sum_.size();
+            const double count = static_cast<double>(out_->count_);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                output(i) = out_->min_[i];
+                output(size + i) = out_->max_[i];
+                output(2 * size + i) = out_->sum_[i] / count;
+            }
+        }
     };
 
 
     class INTROMETRY_HIDDEN SourceContainerBase
     {
+    public:
+        enum class WriteStatus
+        {
+            ACCEPTED,
+            UNASSIGNED
+        };
+
     protected:
         using Key = std::pair<std::type_index, std::string>;
 
@@ -71,9 +485,9 @@ namespace intrometry::backend
     protected:
         CollisionMap collision_counters_;
 
-        // additions and removals of sources are exclusive
-        // visits are shared since there are extra locks for each source
-        std::shared_mutex sources_mutex_;
+        // additions and removals of sources are exclusive, reads are lock-free
+        std::mutex update_mutex_;
+        EpochDomain epoch_domain_;
 
     protected:
         static Key getKey(const std::string &id, const ariles2::DefaultBase &source);
@@ -81,67 +495,136 @@ namespace intrometry::backend
     };
 
 
+    /**
+     * Registry of sources: an immutable snapshot published through an
+     * atomic pointer, assignment and retraction replace the snapshot and
+     * reclaim the old one when no visitors reference it.
+     */
     template <class t_Value>
     class INTROMETRY_HIDDEN SourceContainer : public SourceContainerBase
     {
     protected:
-        using SourceMap = std::unordered_map<Key, t_Value, Hasher>;
+        // values are referenced by source handles
+        using SourceMap = std::unordered_map<Key, std::shared_ptr<t_Value>, Hasher>;
 
-    protected:
-        SourceMap sources_;
-
-    public:
-        void tryFlush(const std::function<void(t_Value &)> visitor)
+        class Snapshot
         {
-            if (sources_mutex_.try_lock_shared())
+        public:
+            SourceMap map_;
+            // the same values in a random access container
+            std::vector<t_Value *> values_;
+
+        public:
+            Snapshot() = default;
+
+            explicit Snapshot(SourceMap map) : map_(std::move(map))
             {
-                for (std::pair<const Key, t_Value> &source : sources_)
+                values_.reserve(map_.size());
+                for (const std::pair<const Key, std::shared_ptr<t_Value>> &source : map_)
                 {
-                    visitor(source.second);
+                    values_.push_back(source.second.get());
                 }
+            }
+        };
+
+    protected:
+        std::atomic<const Snapshot *> sources_;
+
+    protected:
+        /// must be called with update_mutex_ locked
+        void replace(SourceMap sources)
+        {
+            const std::unique_ptr<const Snapshot> old_sources(
+                    sources_.exchange(new Snapshot(std::move(sources))));
+            epoch_domain_.synchronize();
+        }
+
+    public:
+        SourceContainer() : sources_(new Snapshot())
+        {
+        }
 
-                sources_mutex_.unlock();
+        ~SourceContainer()
+        {
+            delete sources_.load();
+        }
+
+        SourceContainer(const SourceContainer &) = delete;
+        SourceContainer &operator=(const SourceContainer &) = delete;
+
+        /// Visit all sources, the set of sources is consistent during the visit
+        void visit(const std::function<void(t_Value &)> visitor)
+        {
+            const EpochDomain::ReadGuard guard(epoch_domain_);
+
+            for (t_Value *source : sources_.load()->values_)
+            {
+                visitor(*source);
             }
         }
 
+        /// @return new or previously assigned source
         template <class... t_Args>
-        void tryEmplace(const std::string &id, const ariles2::DefaultBase &source, t_Args &&...args)
+        std::shared_ptr<t_Value> tryEmplace(const std::string &id, const ariles2::DefaultBase &source, t_Args &&...args)
         {
-            const std::lock_guard lock(sources_mutex_);
+            const std::lock_guard lock(update_mutex_);
+
+            const Key key = getKey(id, source);
+            const SourceMap &sources = sources_.load()->map_;
+            const typename SourceMap::const_iterator source_it = sources.find(key);
+            if (sources.end() != source_it)
+            {
+                return (source_it->second);
+            }
+
+            std::shared_ptr<t_Value> value = std::make_shared<t_Value>(
+                    source, getUniqueId(id.empty() ? source.arilesDefaultID() : id), std::forward<t_Args>(args)...);
 
-            sources_.try_emplace(
-                    getKey(id, source),
-                    source,
-                    getUniqueId(id.empty() ? source.arilesDefaultID() : id),
-                    std::forward<t_Args>(args)...);
+            SourceMap new_sources = sources;
+            new_sources.emplace(key, value);
+            replace(std::move(new_sources));
+
+            return (value);
         }
 
-        void erase(const std::string &id, const ariles2::DefaultBase &source)
+        /// @return erased source or nullptr if the source is not assigned
+        std::shared_ptr<t_Value> erase(const std::string &id, const ariles2::DefaultBase &source)
         {
-            const std::lock_guard lock(sources_mutex_);
+            const std::lock_guard lock(update_mutex_);
+
+            const Key key = getKey(id, source);
+            const SourceMap &sources = sources_.load()->map_;
+            const typename SourceMap::const_iterator source_it = sources.find(key);
+            if (sources.end() == source_it)
+            {
+                return (nullptr);
+            }
+
+            std::shared_ptr<t_Value> value = source_it->second;
+            SourceMap new_sources = sources;
+            new_sources.erase(key);
+            replace(std::move(new_sources));
 
-            sources_.erase(getKey(id, source));
+            return (value);
         }
 
-        bool tryWrite(
+        WriteStatus write(
                 const std::string &id,
                 const ariles2::DefaultBase &source,
                 const std::function<void(t_Value &)> visitor)
         {
-            if (sources_mutex_.try_lock_shared())
-            {
-                const typename SourceMap::iterator source_it = sources_.find(getKey(id, source));
+            const EpochDomain::ReadGuard guard(epoch_domain_);
 
-                if (sources_.end() == source_it)
-                {
-                    sources_mutex_.unlock();
-                    return (false);
-                }
+            const SourceMap &sources = sources_.load()->map_;
+            const typename SourceMap::const_iterator source_it = sources.find(getKey(id, source));
 
-                visitor(source_it->second);
-                sources_mutex_.unlock();
+            if (sources.end() == source_it)
+            {
+                return (WriteStatus::UNASSIGNED);
             }
-            return (true);
+
+            visitor(*source_it->second);
+            return (WriteStatus::ACCEPTED);
         }
     };
 }  // namespace intrometry::backend
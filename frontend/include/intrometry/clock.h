@@ -0,0 +1,61 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Clock parameters.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+
+namespace intrometry
+{
+    /**
+     * @brief Clock used by sinks to timestamp data written without explicit
+     * timestamps.
+     *
+     * Clocks are read on each write, while conversion of readings to
+     * nanoseconds since epoch is performed by the sink thread.
+     *
+     * @ingroup API
+     */
+    class Clock
+    {
+    public:
+        enum class Type
+        {
+            /// std::chrono::system_clock
+            SYSTEM,
+            /**
+             * CPU timestamp counter calibrated against the system clock and
+             * re-anchored to it once per second by the sink thread; requires
+             * invariant TSC, falls back to CLOCK_MONOTONIC on other
+             * architectures.
+             */
+            TSC,
+            /// CLOCK_MONOTONIC_COARSE (resolution of a few milliseconds) with an offset to the system clock
+            MONOTONIC_COARSE,
+            /// user function, which must return nanoseconds since epoch and be safe to call from any thread
+            CUSTOM
+        };
+
+    public:
+        Type type_;
+        std::function<uint64_t()> function_;
+
+    public:
+        explicit Clock(const Type type = Type::SYSTEM) : type_(type)
+        {
+        }
+
+        explicit Clock(std::function<uint64_t()> function) : type_(Type::CUSTOM), function_(std::move(function))
+        {
+        }
+    };
+}  // namespace intrometry
@@ -11,9 +11,44 @@
 
 #include <tuple>
 
+#include "sample.h"
 #include "sink.h"
 
 
+namespace intrometry::combo
+{
+    class FlattenerImplementation;
+
+    /**
+     * Flattens sources of ComboSink into a single sample, names are
+     * concatenated only when the structure of a source changes. Copies get
+     * their own buffers.
+     */
+    class INTROMETRY_PUBLIC Flattener
+    {
+    protected:
+        std::unique_ptr<FlattenerImplementation> pimpl_;
+
+    public:
+        Flattener();
+        Flattener(const Flattener &other);
+        Flattener &operator=(const Flattener &other);
+        Flattener(Flattener &&) noexcept;
+        Flattener &operator=(Flattener &&) noexcept;
+        ~Flattener();
+
+        /// Remove all sources
+        void reset(const bool persistent_structure);
+        /// Add source, ids that are already used get a `_intrometry<N>` suffix
+        void add(const std::string &id);
+        /// Flatten source with the given index (order of addition)
+        void flatten(const std::size_t index, const ariles2::DefaultBase &source);
+        /// Concatenate flattened sources
+        const Sample &finalize();
+    };
+}  // namespace intrometry::combo
+
+
 namespace intrometry
 {
     /**
@@ -21,6 +56,10 @@ namespace intrometry
      *
      * A helper class that contains both a sink and multiple source
      * instances that are automatically assigned to it on initialization.
+     * Since the set of sources is known at compile time, they are written
+     * as a single source: write() flattens all of them into one sample,
+     * which is passed to the sink with a single handle and timestamp, and
+     * is published as one message.
      *
      * @ingroup API
      */
@@ -31,8 +70,26 @@ namespace intrometry
         std::shared_ptr<Sink> sink_;
         std::tuple<t_Ariles...> data_;
 
+    protected:
+        SampleSource placeholder_;
+        SourceHandle handle_;
+        combo::Flattener flattener_;
+        bool deferred_ = false;
+
+    protected:
+        const Sample &flatten()
+        {
+            std::size_t index = 0;
+            std::apply([this, &index](const auto &...sources) { (flattener_.flatten(index++, sources), ...); }, data_);
+            return (flattener_.finalize());
+        }
+
     public:
-        /// Initialize sink and assign sources.
+        /**
+         * Initialize sink and assign sources. If deferred mode is requested
+         * in source parameters, it is enabled for each source with its type,
+         * and sources are written to the sink individually.
+         */
         template <class t_Sink, class... t_Args>
         bool initialize(
                 const Source::Parameters &source_parameters,
@@ -43,10 +100,27 @@ namespace intrometry
             {
                 return (false);
             }
-            std::apply(
-                    [this, source_parameters](auto &&...assign_args)
-                    { sink_->assignBatch(source_parameters, assign_args...); },
-                    data_);
+            deferred_ = static_cast<bool>(source_parameters.copy_);
+            if (deferred_)
+            {
+                std::apply(
+                        [this, source_parameters](auto &&...assign_args)
+                        {
+                            ((void)sink_->assign(
+                                     assign_args,
+                                     Source::Parameters(source_parameters)
+                                             .template deferred<std::decay_t<decltype(assign_args)>>()),
+                             ...);
+                        },
+                        data_);
+            }
+            else
+            {
+                flattener_.reset(source_parameters.persistent_structure_);
+                std::apply([this](const auto &...sources) { (flattener_.add(sources.arilesDefaultID()), ...); }, data_);
+
+                handle_ = sink_->assign("combo", placeholder_, source_parameters);
+            }
             return (true);
         }
 
@@ -60,9 +134,16 @@ namespace intrometry
         /// Write all sources to sink
         void write(const uint64_t timestamp = 0)
         {
-            std::apply(
-                    [this, timestamp](auto &&...write_args) { sink_->writeBatch(timestamp, write_args...); },
-                    data_);
+            if (deferred_)
+            {
+                std::apply(
+                        [this, timestamp](auto &&...write_args) { sink_->writeBatch(timestamp, write_args...); },
+                        data_);
+            }
+            else if (handle_.valid())
+            {
+                sink_->write(handle_, flatten(), timestamp);
+            }
         }
 
         /// Force flushing of pending telemetry data
@@ -0,0 +1,74 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Flattened source.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ariles2/ariles.h>
+
+
+namespace intrometry
+{
+    /**
+     * @brief Names and values of a source produced by a single traversal,
+     * which can be written to multiple sinks, see tee::Sink.
+     *
+     * @ingroup API
+     */
+    class Sample
+    {
+    public:
+        std::vector<std::string> names_;
+        std::vector<double> values_;
+        /// must be changed whenever names change, sinks copy names only in this case
+        uint64_t version_ = 0;
+
+    public:
+        [[nodiscard]] std::size_t size() const
+        {
+            return (values_.size());
+        }
+    };
+
+
+    /**
+     * @brief Fingerprint of names, used to detect structure changes of
+     * non-persistent sources without keeping a copy of previous names.
+     */
+    inline uint64_t hashNames(const std::vector<std::string> &names)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL ^ names.size();
+        for (const std::string &name : names)
+        {
+            hash ^= std::hash<std::string>{}(name) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+        // zero is used as 'unknown' fingerprint, so that empty sources are
+        // reported as changed on the first write
+        return (0 == hash ? 1 : hash);
+    }
+
+
+    /**
+     * @brief Empty source, which is assigned to sinks on behalf of sources
+     * that are written as samples, an explicit id should be used to avoid
+     * collisions.
+     */
+    class SampleSource : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "sample"
+#define ARILES2_ENTRIES(v)
+#include ARILES2_INITIALIZE
+    public:
+        virtual ~SampleSource() = default;
+    };
+}  // namespace intrometry
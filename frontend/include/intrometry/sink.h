@@ -13,7 +13,14 @@
 #include <memory>
 #include <cstdint>
 
+#include "clock.h"
+#include "sample.h"
+#include "thread.h"
 #include "source.h"
+#include "statistics.h"
+
+#define INTROMETRY_PUBLIC __attribute__((visibility("default")))
+#define INTROMETRY_HIDDEN __attribute__((visibility("hidden")))
 
 
 namespace intrometry
@@ -41,12 +48,16 @@ namespace intrometry
          * definition to avoid naming collisions.
          *
          * @note Does nothing if initialization failed.
+         * @return handle that can be used for writing, invalid if
+         * initialization failed.
          */
-        void assign(const ariles2::DefaultBase &source, const Source::Parameters &parameters = Source::Parameters())
+        SourceHandle assign(
+                const ariles2::DefaultBase &source,
+                const Source::Parameters &parameters = Source::Parameters())
         {
-            assign(std::string(), source, parameters);
+            return (assign(std::string(), source, parameters));
         }
-        virtual void assign(
+        virtual SourceHandle assign(
                 const std::string &id,  // use to resolve ambiguity between sources of the same type
                 const ariles2::DefaultBase &source,
                 const Source::Parameters &parameters = Source::Parameters()) = 0;
@@ -76,6 +87,35 @@ namespace intrometry
             write(std::string(), source, timestamp);
         }
         virtual void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp = 0) = 0;
+        /**
+         * Write data using a handle returned by assign(), this is
+         * the fastest option since no lookup is needed.
+         *
+         * @note Does nothing if the handle is invalid or belongs to another sink.
+         * @note Sinks that do not support handles ignore them and look the
+         * source up using the default id.
+         */
+        virtual void write(
+                const SourceHandle & /*handle*/,
+                const ariles2::DefaultBase &source,
+                const uint64_t timestamp = 0)
+        {
+            write(std::string(), source, timestamp);
+        }
+        /**
+         * Write a sample flattened elsewhere, e.g., by tee::Sink, using a
+         * handle of an assigned source with the same structure. Names are
+         * copied only when the sample version changes. Samples written to
+         * deferred sources are counted as unassigned.
+         *
+         * @note Does nothing in sinks that do not support samples.
+         */
+        virtual void write(
+                const SourceHandle & /*handle*/,
+                const Sample & /*sample*/,
+                const uint64_t /*timestamp*/ = 0)
+        {
+        }
 
         /**
          * Force flushing of pending telemetry data, without waiting for the
@@ -85,6 +125,18 @@ namespace intrometry
          */
         virtual void flush() = 0;
 
+        /**
+         * Collect statistics of the sink and its sources, e.g., numbers of
+         * accepted and dropped writes.
+         *
+         * @note Returns zero counters if initialization failed or the sink
+         * does not collect statistics.
+         */
+        [[nodiscard]] virtual SinkStatistics statistics() const
+        {
+            return (SinkStatistics());
+        }
+
 
         /// Batch assignment
         template <class... t_Sources>
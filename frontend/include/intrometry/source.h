@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <memory>
+#include <typeinfo>
+
 #include <ariles2/ariles.h>
 
 
@@ -27,11 +30,67 @@ namespace intrometry
     public:
         class Parameters
         {
+        public:
+            /// Type-erased copy of a source, see deferred()
+            class Copy
+            {
+            public:
+                virtual ~Copy() = default;
+
+                /**
+                 * Create a new instance of the source type initialized with a
+                 * copy of the given source, returns nullptr if types do not match.
+                 */
+                [[nodiscard]] virtual std::unique_ptr<ariles2::DefaultBase> make(
+                        const ariles2::DefaultBase &source) const = 0;
+
+                /**
+                 * Copy-assign source to destination, the destination must be
+                 * created by make(), returns false if the type of the source is
+                 * different.
+                 */
+                [[nodiscard]] virtual bool assign(
+                        ariles2::DefaultBase &destination,
+                        const ariles2::DefaultBase &source) const = 0;
+            };
+
+            template <class t_Source>
+            class TypedCopy : public Copy
+            {
+            public:
+                [[nodiscard]] std::unique_ptr<ariles2::DefaultBase> make(
+                        const ariles2::DefaultBase &source) const override
+                {
+                    if (typeid(source) != typeid(t_Source))
+                    {
+                        return (nullptr);
+                    }
+                    return (std::make_unique<t_Source>(static_cast<const t_Source &>(source)));
+                }
+
+                [[nodiscard]] bool assign(
+                        ariles2::DefaultBase &destination,
+                        const ariles2::DefaultBase &source) const override
+                {
+                    if (typeid(source) != typeid(t_Source))
+                    {
+                        return (false);
+                    }
+                    static_cast<t_Source &>(destination) = static_cast<const t_Source &>(source);
+                    return (true);
+                }
+            };
+
         public:
             /**
              * If true assume that the number and order of entries is
-             * preserved, if false new names are generated and published on
-             * each write (it is unlikely that you want this). It is not
+             * preserved: names are generated only on assignment and when the
+             * number of entries changes, subsequent writes update values
+             * only. If false new names are generated on each write and
+             * republished when their fingerprint changes (it is unlikely that
+             * you want this): each write formats all names and hashes them,
+             * which costs O(total length of names) in the writing thread in
+             * addition to copying values. It is not
              * possible to detect persistent structure automatically, since
              * variable containers may have constant size. Wrong setting is not
              * going to result in an error, but metric IDs and values may not
@@ -39,10 +98,41 @@ namespace intrometry
              */
             bool persistent_structure_;
 
+            /**
+             * If nonzero, enables lossless mode in backends that support it:
+             * written samples are queued in a preallocated buffer of the given
+             * size instead of overwriting unpublished data, and are dropped
+             * only when the buffer is full.
+             */
+            std::size_t buffer_size_;
+
+            /**
+             * If set, enables deferred mode in backends that support it:
+             * write() only copy-assigns the source to one of two preallocated
+             * instances, and conversion to names and values is performed by
+             * the sink thread. Copying should not allocate memory, e.g.,
+             * containers should not grow after assignment. Not compatible
+             * with lossless mode, ignored if the type of the assigned source
+             * is different.
+             */
+            std::shared_ptr<const Copy> copy_;
+
+            /**
+             * If true, enables aggregation in backends that support it: each
+             * write is folded into min / max / mean of values written since
+             * the previous flush, which are published as extra series with
+             * `_min`, `_max`, `_mean` suffixes, so that short spikes are not
+             * lost when writing faster than the sink rate. Not compatible
+             * with lossless and deferred modes.
+             */
+            bool aggregate_;
+
         public:
             explicit Parameters(const bool persistent_structure = false)
             {
                 persistent_structure_ = persistent_structure;
+                buffer_size_ = 0;
+                aggregate_ = false;
             }
 
             Parameters &persistent_structure(const bool value)
@@ -50,6 +140,69 @@ namespace intrometry
                 persistent_structure_ = value;
                 return (*this);
             }
+
+            Parameters &buffer_size(const std::size_t value)
+            {
+                buffer_size_ = value;
+                return (*this);
+            }
+
+            Parameters &aggregate(const bool value)
+            {
+                aggregate_ = value;
+                return (*this);
+            }
+
+            /// Enable deferred mode for sources of the given type
+            template <class t_Source>
+            Parameters &deferred()
+            {
+                copy_ = std::make_shared<const TypedCopy<t_Source>>();
+                return (*this);
+            }
         };
     };
+
+
+    /**
+     * @brief Handle of an assigned source.
+     *
+     * Returned by Sink::assign(), allows to write data without looking up
+     * the source by its id and type. Handles are safe to use after
+     * retraction of the source, writes are ignored in this case.
+     *
+     * @ingroup API
+     */
+    class SourceHandle
+    {
+    protected:
+        const void *owner_;
+        std::weak_ptr<void> source_;
+
+    public:
+        SourceHandle() : owner_(nullptr)
+        {
+        }
+
+        SourceHandle(const void *owner, std::weak_ptr<void> source) : owner_(owner), source_(std::move(source))
+        {
+        }
+
+        /// Returns false if the source is retracted or has never been assigned
+        [[nodiscard]] bool valid() const
+        {
+            return (not source_.expired());
+        }
+
+        /// Used by backends, returns nullptr if the handle belongs to a different owner.
+        template <class t_Source>
+        [[nodiscard]] std::shared_ptr<t_Source> lock(const void *owner) const
+        {
+            if (owner != owner_ or nullptr == owner)
+            {
+                return (nullptr);
+            }
+            return (std::static_pointer_cast<t_Source>(source_.lock()));
+        }
+    };
 }  // namespace intrometry
@@ -0,0 +1,131 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Sink statistics.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "source.h"
+
+
+namespace intrometry
+{
+    /**
+     * @brief Source statistics (counters since assignment).
+     *
+     * @ingroup API
+     */
+    class SourceStatistics : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "source"
+#define ARILES2_ENTRIES(v)                                                                                             \
+    ARILES2_TYPED_ENTRY_(v, accepted, uint64_t)                                                                        \
+    ARILES2_TYPED_ENTRY_(v, dropped_busy, uint64_t)                                                                    \
+    ARILES2_TYPED_ENTRY_(v, dropped_full, uint64_t)                                                                    \
+    ARILES2_TYPED_ENTRY_(v, overwritten, uint64_t)                                                                     \
+    ARILES2_TYPED_ENTRY_(v, flushed, uint64_t)                                                                         \
+    ARILES2_TYPED_ENTRY_(v, flush_busy, uint64_t)                                                                      \
+    ARILES2_TYPED_ENTRY_(v, bytes, uint64_t)
+#include ARILES2_INITIALIZE
+
+    public:
+        /*
+         * accepted:     writes copied to internal buffers
+         * dropped_busy: writes dropped due to a concurrent write or flush
+         * dropped_full: writes dropped due to a full buffer (lossless mode)
+         * overwritten:  accepted samples overwritten before being flushed
+         * flushed:      samples passed to the backend
+         * flush_busy:   flush attempts skipped due to a concurrent write
+         * bytes:        approximate size of flushed names and values
+         */
+
+        /// unique id of the source, not an ariles entry
+        std::string id_;
+
+    public:
+        SourceStatistics()
+        {
+            accepted_ = 0;
+            dropped_busy_ = 0;
+            dropped_full_ = 0;
+            overwritten_ = 0;
+            flushed_ = 0;
+            flush_busy_ = 0;
+            bytes_ = 0;
+        }
+
+        SourceStatistics &operator+=(const SourceStatistics &other)
+        {
+            accepted_ += other.accepted_;
+            dropped_busy_ += other.dropped_busy_;
+            dropped_full_ += other.dropped_full_;
+            overwritten_ += other.overwritten_;
+            flushed_ += other.flushed_;
+            flush_busy_ += other.flush_busy_;
+            bytes_ += other.bytes_;
+            return (*this);
+        }
+    };
+
+
+    /**
+     * @brief Sink statistics (counters since initialization).
+     *
+     * @ingroup API
+     */
+    class SinkStatistics : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "intrometry_statistics"
+#define ARILES2_ENTRIES(v)                                                                                             \
+    ARILES2_TYPED_ENTRY_(v, unassigned, uint64_t)                                                                      \
+    ARILES2_TYPED_ENTRY_(v, flush_ticks, uint64_t)                                                                     \
+    ARILES2_TYPED_ENTRY_(v, flush_overruns, uint64_t)                                                                  \
+    ARILES2_TYPED_ENTRY_(v, io_stalls, uint64_t)                                                                       \
+    ARILES2_TYPED_ENTRY_(v, unsubscribed, uint64_t)                                                                    \
+    ARILES2_TYPED_ENTRY_(v, thread_cpu, int64_t)                                                                       \
+    ARILES2_TYPED_ENTRY_(v, thread_policy, int64_t)                                                                    \
+    ARILES2_TYPED_ENTRY_(v, thread_nice, int64_t)                                                                      \
+    ARILES2_TYPED_ENTRY_(v, thread_errors, uint64_t)                                                                   \
+    ARILES2_TYPED_ENTRY_(v, total, SourceStatistics)
+#include ARILES2_INITIALIZE
+
+    public:
+        /*
+         * unassigned:     writes to unassigned sources
+         * flush_ticks:    flushes performed
+         * flush_overruns: periodic flushes skipped due to slow flushing
+         * io_stalls:      samples not flushed due to full I/O queue
+         * unsubscribed:   samples dropped due to absence of subscribers
+         * thread_cpu:     CPU the sink thread was last running on, -1 if unknown
+         * thread_policy:  scheduling policy of the sink thread (SCHED_*)
+         * thread_nice:    nice level of the sink thread
+         * thread_errors:  ThreadParameters that could not be applied
+         * total:          sum of all source statistics
+         */
+
+        /// statistics of individual sources, not an ariles entry
+        std::vector<SourceStatistics> sources_;
+
+    public:
+        SinkStatistics()
+        {
+            unassigned_ = 0;
+            flush_ticks_ = 0;
+            flush_overruns_ = 0;
+            io_stalls_ = 0;
+            unsubscribed_ = 0;
+            thread_cpu_ = -1;
+            thread_policy_ = 0;
+            thread_nice_ = 0;
+            thread_errors_ = 0;
+        }
+    };
+}  // namespace intrometry
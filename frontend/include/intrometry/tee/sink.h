@@ -0,0 +1,84 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Fan-out sink.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <intrometry/sink.h>
+#include <intrometry/backend/utils.h>
+
+
+namespace intrometry::tee
+{
+    namespace sink
+    {
+        class INTROMETRY_PUBLIC Parameters
+        {
+        public:
+            /// sinks that receive all samples, initialized by the tee sink
+            std::vector<std::shared_ptr<intrometry::Sink>> sinks_;
+
+            /**
+             * Initialize sinks and assign sources in a separate thread:
+             * initialize() and assign() do not block, writes are ignored
+             * until the corresponding assignment is completed (see ready()),
+             * memory is allocated by the first accepted write.
+             */
+            bool asynchronous_;
+
+        public:
+            // cppcheck-suppress noExplicitConstructor
+            Parameters(std::vector<std::shared_ptr<intrometry::Sink>> sinks = {});  // NOLINT
+
+            Parameters &sink(std::shared_ptr<intrometry::Sink> value);
+            Parameters &asynchronous(const bool value);
+        };
+
+        class Implementation;
+    }  // namespace sink
+
+
+    /**
+     * @brief Flatten sources once per write() and pass the resulting sample
+     * to several sinks, e.g., `pjmsg_topic` and `pjmsg_mcap`.
+     *
+     * Sources are assigned to all sinks, deferred mode is not supported and
+     * is ignored. Statistics are accumulated over all sinks. In asynchronous
+     * mode a single sink can be wrapped to avoid blocking in initialize() and
+     * assign().
+     */
+    class INTROMETRY_PUBLIC Sink : public SinkPIMPLBase<sink::Parameters, sink::Implementation>
+    {
+    public:
+        using SinkPIMPLBase::assign;
+        using SinkPIMPLBase::retract;
+        using SinkPIMPLBase::SinkPIMPLBase;
+        using SinkPIMPLBase::write;
+        ~Sink();
+
+        /// @return true if all sinks are initialized, always true in asynchronous mode, see failed()
+        bool initialize();
+        SourceHandle assign(
+                const std::string &id,
+                const ariles2::DefaultBase &source,
+                const Source::Parameters &parameters = Source::Parameters());
+        void retract(const std::string &id, const ariles2::DefaultBase &source);
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp = 0);
+        void flush();
+        [[nodiscard]] SinkStatistics statistics() const;
+
+        /// @return true if all sinks are initialized and all sources are assigned (asynchronous mode)
+        [[nodiscard]] bool ready() const;
+        /// @return true if initialization of a sink has failed, in asynchronous mode it is reported by the thread
+        [[nodiscard]] bool failed() const;
+    };
+}  // namespace intrometry::tee
@@ -0,0 +1,78 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Thread parameters.
+*/
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace intrometry
+{
+    /**
+     * @brief Placement of threads spawned by sinks, applied by each thread
+     * on startup.
+     *
+     * Real time policies are deliberately not supported: sink threads are
+     * meant to stay out of the way of control threads.
+     *
+     * @ingroup API
+     */
+    class ThreadParameters
+    {
+    public:
+        enum class Policy
+        {
+            /// keep the policy of the thread creating the sink
+            INHERIT,
+            /// SCHED_OTHER
+            OTHER,
+            /// SCHED_BATCH
+            BATCH,
+            /// SCHED_IDLE
+            IDLE
+        };
+
+    public:
+        /// allowed CPUs, empty -- inherit affinity
+        std::vector<int> cpus_;
+        Policy policy_ = Policy::INHERIT;
+        /// nice level [-20, 19], ignored with IDLE policy
+        std::optional<int> nice_;
+        /// thread name, truncated to 15 characters
+        std::string name_;
+
+    public:
+        ThreadParameters &cpus(std::vector<int> value)
+        {
+            cpus_ = std::move(value);
+            return (*this);
+        }
+
+        ThreadParameters &policy(const Policy value)
+        {
+            policy_ = value;
+            return (*this);
+        }
+
+        ThreadParameters &nice(const int value)
+        {
+            nice_ = value;
+            return (*this);
+        }
+
+        ThreadParameters &name(std::string value)
+        {
+            name_ = std::move(value);
+            return (*this);
+        }
+    };
+}  // namespace intrometry
@@ -14,6 +14,21 @@
 #include <sstream>
 #include <string_view>
 #include <iomanip>
+#include <cmath>
+#include <ctime>
+#include <cerrno>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
 
 #include <intrometry/backend/utils.h>
 
@@ -95,6 +110,73 @@ namespace intrometry::backend
 
         return (result);
     }
+
+
+    INTROMETRY_HIDDEN std::string configureThread(const ThreadParameters &parameters)
+    {
+        std::string errors;
+
+        if (not parameters.name_.empty())
+        {
+            // names are limited to 16 bytes including the terminating null
+            if (0 != pthread_setname_np(pthread_self(), parameters.name_.substr(0, 15).c_str()))
+            {
+                errors += "name; ";
+            }
+        }
+
+        if (not parameters.cpus_.empty())
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for (const int cpu : parameters.cpus_)
+            {
+                if (cpu >= 0 and cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &cpu_set);
+                }
+            }
+            if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set))
+            {
+                errors += "cpus; ";
+            }
+        }
+
+        int policy = -1;
+        switch (parameters.policy_)
+        {
+            case ThreadParameters::Policy::INHERIT:
+                break;
+            case ThreadParameters::Policy::OTHER:
+                policy = SCHED_OTHER;
+                break;
+            case ThreadParameters::Policy::BATCH:
+                policy = SCHED_BATCH;
+                break;
+            case ThreadParameters::Policy::IDLE:
+                policy = SCHED_IDLE;
+                break;
+        }
+        if (policy >= 0)
+        {
+            const sched_param parameter{};
+            if (0 != pthread_setschedparam(pthread_self(), policy, &parameter))
+            {
+                errors += "policy; ";
+            }
+        }
+
+        if (parameters.nice_.has_value())
+        {
+            // on Linux nice level is a per thread property, 0 refers to the calling thread
+            if (0 != setpriority(PRIO_PROCESS, 0, parameters.nice_.value()))
+            {
+                errors += "nice; ";
+            }
+        }
+
+        return (errors);
+    }
 }  // namespace intrometry::backend
 
 
@@ -103,16 +185,95 @@ namespace intrometry::backend
     class RateTimer::Implementation
     {
     public:
-        const std::chrono::nanoseconds step_;  // NOLINT
-        std::chrono::time_point<std::chrono::steady_clock> time_threshold_;
+        const uint64_t step_;               // NOLINT
+        const std::size_t max_idle_steps_;  // NOLINT
+        uint64_t deadline_;
+
+        int timer_fd_;
+        int event_fd_;
+
+        // set by writers, reset by step()
+        std::atomic<bool> pending_;
+        // set while waiting for notify()
+        std::atomic<bool> sleeping_;
+        std::atomic<bool> interrupted_;
 
     public:
-        explicit Implementation(const std::size_t rate) : step_(std::nano::den / rate)
+        explicit Implementation(const std::size_t rate, const std::size_t max_idle_steps)
+          : step_(rate > 0 ? std::nano::den / rate : 0), max_idle_steps_(max_idle_steps)
+        {
+            deadline_ = 0;
+            pending_ = false;
+            sleeping_ = false;
+            interrupted_ = false;
+            timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+            event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        }
+
+        ~Implementation()
         {
+            if (timer_fd_ >= 0)
+            {
+                close(timer_fd_);
+            }
+            if (event_fd_ >= 0)
+            {
+                close(event_fd_);
+            }
+        }
+
+        static uint64_t now()
+        {
+            timespec time{};
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return (static_cast<uint64_t>(time.tv_sec) * std::nano::den + static_cast<uint64_t>(time.tv_nsec));
+        }
+
+        void signal() const
+        {
+            const uint64_t increment = 1;
+            // failure means that the counter is already nonzero
+            [[maybe_unused]] const ssize_t result = ::write(event_fd_, &increment, sizeof(increment));
+        }
+
+        /**
+         * Wait until deadline (0 -- indefinitely) or signal().
+         * @return false if woken up by signal()
+         */
+        bool wait(const uint64_t deadline) const
+        {
+            itimerspec timer{};
+            timer.it_value.tv_sec = static_cast<time_t>(deadline / std::nano::den);
+            timer.it_value.tv_nsec = static_cast<long>(deadline % std::nano::den);  // NOLINT
+            // zero it_value disarms the timer
+            timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &timer, nullptr);
+
+            std::array<pollfd, 2> fds{};
+            fds[0].fd = timer_fd_;
+            fds[0].events = POLLIN;
+            fds[1].fd = event_fd_;
+            fds[1].events = POLLIN;
+
+            while (poll(fds.data(), fds.size(), -1) < 0 and EINTR == errno)
+            {
+            }
+
+            uint64_t counter = 0;
+            if (0 != (fds[1].revents & POLLIN))
+            {
+                [[maybe_unused]] const ssize_t result = ::read(event_fd_, &counter, sizeof(counter));
+                return (false);
+            }
+            if (0 != (fds[0].revents & POLLIN))
+            {
+                [[maybe_unused]] const ssize_t result = ::read(timer_fd_, &counter, sizeof(counter));
+            }
+            return (true);
         }
     };
 
-    RateTimer::RateTimer(const std::size_t rate) : pimpl_(std::make_unique<RateTimer::Implementation>(rate))
+    RateTimer::RateTimer(const std::size_t rate, const std::size_t max_idle_steps)
+      : pimpl_(std::make_unique<RateTimer::Implementation>(rate, max_idle_steps))
     {
     }
 
@@ -120,20 +281,663 @@ namespace intrometry::backend
 
     bool RateTimer::valid() const
     {
-        return (pimpl_->step_.count() > 0);
+        return (pimpl_->step_ > 0 and pimpl_->timer_fd_ >= 0 and pimpl_->event_fd_ >= 0);
     }
 
     void RateTimer::start()
     {
-        pimpl_->time_threshold_ = std::chrono::steady_clock::now();
+        pimpl_->deadline_ = Implementation::now();
     }
 
-    void RateTimer::step()
+    std::size_t RateTimer::step()
     {
+        if (pimpl_->interrupted_.load(std::memory_order_relaxed))
+        {
+            return (0);
+        }
+
         // the clock is monotonic, so this is always >= 0
-        const std::chrono::nanoseconds time_diff = std::chrono::steady_clock::now() - pimpl_->time_threshold_;
-        pimpl_->time_threshold_ += (time_diff / pimpl_->step_ + 1) * pimpl_->step_;
-        std::this_thread::sleep_until(pimpl_->time_threshold_);
+        const uint64_t time_diff = Implementation::now() - pimpl_->deadline_;
+        const std::size_t skipped_steps = time_diff / pimpl_->step_;
+        pimpl_->deadline_ += (skipped_steps + 1) * pimpl_->step_;
+
+        if (1 == pimpl_->max_idle_steps_ or pimpl_->pending_.exchange(false))
+        {
+            pimpl_->wait(pimpl_->deadline_);
+            return (skipped_steps);
+        }
+
+        // idle: pairs with notify(), either the writer sees the flag or we see the data
+        pimpl_->sleeping_.store(true);
+        if (pimpl_->pending_.exchange(false))
+        {
+            pimpl_->sleeping_.store(false);
+            pimpl_->wait(pimpl_->deadline_);
+            return (skipped_steps);
+        }
+
+        const uint64_t idle_deadline =
+                0 == pimpl_->max_idle_steps_ ? 0 : pimpl_->deadline_ + (pimpl_->max_idle_steps_ - 1) * pimpl_->step_;
+        const bool timeout = pimpl_->wait(idle_deadline);
+        pimpl_->sleeping_.store(false);
+
+        if (timeout)
+        {
+            pimpl_->deadline_ = idle_deadline;
+        }
+        else
+        {
+            // keep cadence if woken up before the current deadline, otherwise step immediately
+            const uint64_t time = Implementation::now();
+            if (time < pimpl_->deadline_)
+            {
+                pimpl_->wait(pimpl_->deadline_);
+            }
+            else
+            {
+                pimpl_->deadline_ = time;
+            }
+        }
+        return (0);
+    }
+
+    void RateTimer::notify()
+    {
+        // The load must not be reordered before the preceding release of the written data (mutex unlock),
+        // otherwise step() may reset the flag and miss the data. A stale 'true' can then only be observed
+        // concurrently with step() resetting the flag, which is followed by one more full step.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (not pimpl_->pending_.load(std::memory_order_relaxed))
+        {
+            pimpl_->pending_.store(true);
+            if (pimpl_->sleeping_.load())
+            {
+                pimpl_->signal();
+            }
+        }
+    }
+
+    void RateTimer::interrupt()
+    {
+        pimpl_->interrupted_.store(true);
+        pimpl_->signal();
+    }
+}  // namespace intrometry::backend
+
+
+namespace intrometry::backend
+{
+    FlushService::Task::Task(const std::size_t rate, const std::size_t max_idle_steps, Function function)
+      : step_(rate > 0 ? std::nano::den / rate : 0)
+      , max_idle_steps_(max_idle_steps)
+      , function_(std::move(function))
+      , service_(nullptr)
+    {
+        pending_ = false;
+        sleeping_ = false;
+        woken_ = false;
+        skipped_steps_ = 0;
+        active_ = false;
+        queued_ = false;
+        running_ = false;
+    }
+
+    bool FlushService::Task::valid() const
+    {
+        return (step_.count() > 0);
+    }
+
+    void FlushService::Task::notify()
+    {
+        // see RateTimer::notify()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (not pending_.load(std::memory_order_relaxed))
+        {
+            pending_.store(true);
+            if (sleeping_.load())
+            {
+                service_->wake(*this);
+            }
+        }
+    }
+
+
+    FlushService::FlushService(const std::size_t threads, const ThreadParameters &thread_parameters)
+    {
+        event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+        started_ = 0;
+        stop_ = false;
+        threads_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            threads_.emplace_back(&FlushService::spin, this, thread_parameters);
+        }
+
+        // wait for configuration of all threads, see getThreadErrors()
+        std::unique_lock lock(mutex_);
+        finished_.wait(lock, [this]() { return (started_ == threads_.size()); });
+    }
+
+    FlushService::~FlushService()
+    {
+        {
+            const std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        signal(threads_.size());
+
+        for (std::thread &thread : threads_)
+        {
+            thread.join();
+        }
+
+        if (event_fd_ >= 0)
+        {
+            close(event_fd_);
+        }
+    }
+
+    std::shared_ptr<FlushService> FlushService::get(
+            const std::size_t threads,
+            const ThreadParameters &thread_parameters)
+    {
+        static std::mutex mutex;
+        static std::weak_ptr<FlushService> instance;
+
+        const std::lock_guard lock(mutex);
+        std::shared_ptr<FlushService> result = instance.lock();
+        if (not result)
+        {
+            result = std::make_shared<FlushService>(threads, thread_parameters);
+            instance = result;
+        }
+        return (result);
+    }
+
+    std::string FlushService::getThreadErrors()
+    {
+        const std::lock_guard lock(mutex_);
+        return (thread_errors_);
+    }
+
+    void FlushService::signal(const uint64_t count) const
+    {
+        // failure means that the counter is already nonzero, i.e., threads are being woken up
+        [[maybe_unused]] const ssize_t result = ::write(event_fd_, &count, sizeof(count));
+    }
+
+    void FlushService::wait(const Task::TimePoint &deadline) const
+    {
+        pollfd fd{};
+        fd.fd = event_fd_;
+        fd.events = POLLIN;
+
+        timespec timeout{};
+        timespec *timeout_ptr = nullptr;
+        if (Task::TimePoint::max() != deadline)
+        {
+            const uint64_t duration = static_cast<uint64_t>(
+                    std::max(std::chrono::nanoseconds(0), deadline - std::chrono::steady_clock::now()).count());
+            timeout.tv_sec = static_cast<time_t>(duration / std::nano::den);
+            timeout.tv_nsec = static_cast<long>(duration % std::nano::den);  // NOLINT
+            timeout_ptr = &timeout;
+        }
+        else if (event_fd_ < 0)
+        {
+            // wakeups cannot be signalled, poll instead
+            timeout.tv_nsec = 10000000;  // NOLINT, 10ms
+            timeout_ptr = &timeout;
+        }
+
+        if (ppoll(&fd, 1, timeout_ptr, nullptr) > 0 and 0 != (fd.revents & POLLIN))
+        {
+            uint64_t counter = 0;
+            // another thread may have consumed the signal
+            [[maybe_unused]] const ssize_t result = ::read(event_fd_, &counter, sizeof(counter));
+        }
+    }
+
+    void FlushService::spin(const ThreadParameters &thread_parameters)
+    {
+        const std::string errors = configureThread(thread_parameters);
+
+        std::unique_lock lock(mutex_);
+        thread_errors_ += errors;
+        ++started_;
+        finished_.notify_all();
+        while (not stop_)
+        {
+            requeue();
+
+            const Task::TimePoint deadline = queue_.empty() ? Task::TimePoint::max() : queue_.begin()->first;
+            if (deadline > std::chrono::steady_clock::now())
+            {
+                lock.unlock();
+                wait(deadline);
+                lock.lock();
+                continue;
+            }
+
+            const std::multimap<Task::TimePoint, Task *>::iterator first = queue_.begin();
+            Task &task = *first->second;
+            task.deadline_ = first->first;
+            queue_.erase(first);
+            task.queued_ = false;
+            task.running_ = true;
+            task.sleeping_.store(false);
+            const std::size_t skipped_steps = task.skipped_steps_;
+            lock.unlock();
+
+            task.function_(skipped_steps);
+
+            lock.lock();
+            task.running_ = false;
+            if (task.active_)
+            {
+                schedule(task);
+            }
+            finished_.notify_all();
+        }
+    }
+
+    void FlushService::schedule(Task &task)
+    {
+        const Task::TimePoint now = std::chrono::steady_clock::now();
+        // the clock is monotonic, so this is always >= 0
+        task.skipped_steps_ = (now - task.deadline_) / task.step_;
+        task.deadline_ += (task.skipped_steps_ + 1) * task.step_;
+        Task::TimePoint deadline = task.deadline_;
+
+        if (1 != task.max_idle_steps_ and not task.pending_.exchange(false))
+        {
+            // idle: pairs with Task::notify()
+            task.sleeping_.store(true);
+            if (task.pending_.exchange(false))
+            {
+                task.sleeping_.store(false);
+            }
+            else
+            {
+                task.skipped_steps_ = 0;
+                if (0 == task.max_idle_steps_)
+                {
+                    // wait for wake()
+                    return;
+                }
+                deadline += (task.max_idle_steps_ - 1) * task.step_;
+            }
+        }
+
+        task.position_ = queue_.emplace(deadline, &task);
+        task.queued_ = true;
+    }
+
+    void FlushService::requeue()
+    {
+        for (Task *task : tasks_)
+        {
+            if (not task->woken_.exchange(false) or not task->sleeping_.load())
+            {
+                continue;
+            }
+            task->sleeping_.store(false);
+            if (task->queued_)
+            {
+                queue_.erase(task->position_);
+            }
+
+            // keep cadence if woken up before the current deadline, otherwise execute immediately
+            const Task::TimePoint now = std::chrono::steady_clock::now();
+            if (now > task->deadline_)
+            {
+                task->deadline_ = now;
+            }
+            task->position_ = queue_.emplace(task->deadline_, task);
+            task->queued_ = true;
+        }
+    }
+
+    void FlushService::wake(Task &task)
+    {
+        if (not task.woken_.exchange(true))
+        {
+            signal();
+        }
+    }
+
+    void FlushService::add(Task &task)
+    {
+        {
+            const std::lock_guard lock(mutex_);
+            task.service_ = this;
+            task.active_ = true;
+            task.deadline_ = std::chrono::steady_clock::now();
+            task.position_ = queue_.emplace(task.deadline_, &task);
+            task.queued_ = true;
+            tasks_.push_back(&task);
+        }
+        signal();
+    }
+
+    void FlushService::remove(Task &task)
+    {
+        std::unique_lock lock(mutex_);
+        task.active_ = false;
+        if (task.queued_)
+        {
+            queue_.erase(task.position_);
+            task.queued_ = false;
+        }
+        tasks_.erase(std::remove(tasks_.begin(), tasks_.end(), &task), tasks_.end());
+        finished_.wait(lock, [&task]() { return (not task.running_); });
+    }
+}  // namespace intrometry::backend
+
+
+namespace intrometry::backend
+{
+    SourceCounters::SourceCounters()
+    {
+        accepted_ = 0;
+        dropped_busy_ = 0;
+        dropped_full_ = 0;
+        overwritten_ = 0;
+        flushed_ = 0;
+        flush_busy_ = 0;
+        bytes_ = 0;
+    }
+
+    void SourceCounters::get(SourceStatistics &statistics) const
+    {
+        statistics.accepted_ = accepted_.load(std::memory_order_relaxed);
+        statistics.dropped_busy_ = dropped_busy_.load(std::memory_order_relaxed);
+        statistics.dropped_full_ = dropped_full_.load(std::memory_order_relaxed);
+        statistics.overwritten_ = overwritten_.load(std::memory_order_relaxed);
+        statistics.flushed_ = flushed_.load(std::memory_order_relaxed);
+        statistics.flush_busy_ = flush_busy_.load(std::memory_order_relaxed);
+        statistics.bytes_ = bytes_.load(std::memory_order_relaxed);
+    }
+
+
+    SinkCounters::SinkCounters()
+    {
+        unassigned_ = 0;
+        flush_ticks_ = 0;
+        flush_overruns_ = 0;
+        io_stalls_ = 0;
+        unsubscribed_ = 0;
+        thread_cpu_ = -1;
+        thread_policy_ = 0;
+        thread_nice_ = 0;
+        thread_errors_ = 0;
+    }
+
+    void SinkCounters::get(SinkStatistics &statistics) const
+    {
+        statistics.unassigned_ = unassigned_.load(std::memory_order_relaxed);
+        statistics.flush_ticks_ = flush_ticks_.load(std::memory_order_relaxed);
+        statistics.flush_overruns_ = flush_overruns_.load(std::memory_order_relaxed);
+        statistics.io_stalls_ = io_stalls_.load(std::memory_order_relaxed);
+        statistics.unsubscribed_ = unsubscribed_.load(std::memory_order_relaxed);
+        statistics.thread_cpu_ = thread_cpu_.load(std::memory_order_relaxed);
+        statistics.thread_policy_ = thread_policy_.load(std::memory_order_relaxed);
+        statistics.thread_nice_ = thread_nice_.load(std::memory_order_relaxed);
+        statistics.thread_errors_ = thread_errors_.load(std::memory_order_relaxed);
+
+        statistics.total_ = SourceStatistics();
+        for (const SourceStatistics &source : statistics.sources_)
+        {
+            statistics.total_ += source;
+        }
+    }
+
+    void SinkCounters::sampleThread()
+    {
+        thread_cpu_.store(sched_getcpu(), std::memory_order_relaxed);
+        thread_policy_.store(sched_getscheduler(0), std::memory_order_relaxed);
+        errno = 0;
+        // on Linux nice level is a per thread property, 0 refers to the calling thread
+        const int nice = getpriority(PRIO_PROCESS, 0);
+        if (0 == errno)
+        {
+            thread_nice_.store(nice, std::memory_order_relaxed);
+        }
+    }
+}  // namespace intrometry::backend
+
+
+namespace intrometry::backend
+{
+    Clock::Clock(const intrometry::Clock &parameters) : parameters_(parameters)
+    {
+        sequence_ = 0;
+        anchor_ticks_ = 0;
+        anchor_nanoseconds_ = 0;
+        nanoseconds_per_tick_ = 1.0;
+        origin_ticks_ = 0;
+        origin_nanoseconds_ = 0;
+
+        if (raw())
+        {
+            read(origin_ticks_, origin_nanoseconds_);
+#if defined(__x86_64__) || defined(__i386__)
+            if (intrometry::Clock::Type::TSC == parameters_.type_)
+            {
+                // initial calibration, refined by anchor()
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+#endif
+            anchor();
+        }
+    }
+
+
+    void Clock::read(uint64_t &ticks, uint64_t &nanoseconds) const
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (intrometry::Clock::Type::TSC == parameters_.type_)
+        {
+            const uint64_t before = __rdtsc();
+            nanoseconds = intrometry::backend::now();
+            const uint64_t after = __rdtsc();
+            ticks = before + (after - before) / 2;
+            return;
+        }
+#endif
+        // coarse clock shares the time base with the precise one
+        timespec time = {};
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        nanoseconds = intrometry::backend::now();
+        ticks = static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+
+    uint64_t Clock::ticks() const
+    {
+        switch (parameters_.type_)
+        {
+            case intrometry::Clock::Type::SYSTEM:
+                break;
+
+            case intrometry::Clock::Type::TSC:
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                return (__rdtsc());
+#else
+                timespec time = {};
+                clock_gettime(CLOCK_MONOTONIC, &time);
+                return (static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec));
+#endif
+            }
+
+            case intrometry::Clock::Type::MONOTONIC_COARSE:
+            {
+                timespec time = {};
+                clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+                return (static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec));
+            }
+
+            case intrometry::Clock::Type::CUSTOM:
+                if (parameters_.function_)
+                {
+                    return (parameters_.function_());
+                }
+                break;
+        }
+        return (intrometry::backend::now());
+    }
+
+
+    uint64_t Clock::toNanoseconds(const uint64_t ticks) const
+    {
+        if (not raw())
+        {
+            return (ticks);
+        }
+
+        uint64_t sequence = 0;
+        uint64_t anchor_ticks = 0;
+        uint64_t anchor_nanoseconds = 0;
+        double nanoseconds_per_tick = 1.0;
+        do
+        {
+            sequence = sequence_.load(std::memory_order_acquire);
+            anchor_ticks = anchor_ticks_.load(std::memory_order_relaxed);
+            anchor_nanoseconds = anchor_nanoseconds_.load(std::memory_order_relaxed);
+            nanoseconds_per_tick = nanoseconds_per_tick_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (0 != (sequence & 1) or sequence != sequence_.load(std::memory_order_relaxed));
+
+        // readings may precede the anchor
+        const double offset =
+                static_cast<double>(static_cast<int64_t>(ticks - anchor_ticks)) * nanoseconds_per_tick;
+        return (anchor_nanoseconds + static_cast<uint64_t>(std::llround(offset)));
+    }
+
+
+    void Clock::anchor()
+    {
+        if (not raw())
+        {
+            return;
+        }
+
+        uint64_t ticks = 0;
+        uint64_t nanoseconds = 0;
+        read(ticks, nanoseconds);
+
+        double nanoseconds_per_tick = nanoseconds_per_tick_.load(std::memory_order_relaxed);
+#if defined(__x86_64__) || defined(__i386__)
+        if (intrometry::Clock::Type::TSC == parameters_.type_ and ticks > origin_ticks_
+            and nanoseconds > origin_nanoseconds_)
+        {
+            // frequency estimate improves with time
+            nanoseconds_per_tick = static_cast<double>(nanoseconds - origin_nanoseconds_)
+                                   / static_cast<double>(ticks - origin_ticks_);
+        }
+#endif
+
+        const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchor_ticks_.store(ticks, std::memory_order_relaxed);
+        anchor_nanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+        nanoseconds_per_tick_.store(nanoseconds_per_tick, std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+}  // namespace intrometry::backend
+
+
+namespace intrometry::backend
+{
+    Aggregator::Aggregator()
+    {
+        in_ = &windows_[0];
+        out_ = &windows_[1];
+    }
+
+    void Aggregator::fold(const std::vector<double> &values)
+    {
+        const std::size_t size = values.size();
+        if (0 == in_->count_ or in_->sum_.size() != size)
+        {
+            in_->min_.assign(values.begin(), values.end());
+            in_->max_.assign(values.begin(), values.end());
+            in_->sum_.assign(values.begin(), values.end());
+            in_->count_ = 1;
+        }
+        else
+        {
+            // separate loops over contiguous arrays are vectorized by the compiler
+            const double *const input = values.data();
+            double *const min = in_->min_.data();
+            double *const max = in_->max_.data();
+            double *const sum = in_->sum_.data();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                min[i] = std::min(input[i], min[i]);
+            }
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                max[i] = std::max(input[i], max[i]);
+            }
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                sum[i] += input[i];
+            }
+            ++in_->count_;
+        }
+    }
+
+    bool Aggregator::swap()
+    {
+        // previous window is consumed: it is going to be restarted by the next fold()
+        out_->count_ = 0;
+        std::swap(in_, out_);
+        return (out_->count_ > 0);
+    }
+}  // namespace intrometry::backend
+
+
+namespace intrometry::backend
+{
+    EpochDomain::EpochDomain()
+    {
+        for (Shard &shard : shards_)
+        {
+            shard.readers_[0] = 0;
+            shard.readers_[1] = 0;
+        }
+        epoch_ = 0;
+    }
+
+    std::size_t EpochDomain::getShard()
+    {
+        static thread_local const std::size_t shard =
+                std::hash<std::thread::id>{}(std::this_thread::get_id()) % shards_number_;
+        return (shard);
+    }
+
+    void EpochDomain::wait(const std::size_t parity) const
+    {
+        for (const Shard &shard : shards_)
+        {
+            while (shard.readers_[parity].load(std::memory_order_seq_cst) > 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void EpochDomain::synchronize()
+    {
+        // Readers that loaded old data are registered in one of the two
+        // counter sets: drain the inactive set, then switch the parity so
+        // that new readers do not delay draining of the active set.
+        const std::size_t epoch = epoch_.load(std::memory_order_relaxed);
+        wait((epoch + 1) & 1);
+        epoch_.store(epoch + 1, std::memory_order_seq_cst);
+        wait(epoch & 1);
     }
 }  // namespace intrometry::backend
 
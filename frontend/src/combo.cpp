@@ -0,0 +1,158 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <algorithm>
+
+#include "intrometry/combo.h"
+#include "sample_container.h"
+
+
+namespace
+{
+    class Element
+    {
+    public:
+        std::string id_;
+        ariles2::namevalue2::Writer::Parameters writer_parameters_;
+        std::shared_ptr<intrometry::backend::SampleContainer> data_;
+        ariles2::namevalue2::Writer writer_;
+
+    public:
+        Element(std::string id, const bool persistent_structure)
+          : id_(std::move(id)), data_(std::make_shared<intrometry::backend::SampleContainer>()), writer_(data_)
+        {
+            writer_parameters_ = writer_.getDefaultParameters();
+            writer_parameters_.persistent_structure_ = persistent_structure;
+        }
+    };
+}  // namespace
+
+
+namespace intrometry::combo
+{
+    class FlattenerImplementation
+    {
+    public:
+        std::vector<std::unique_ptr<Element>> elements_;
+        Sample sample_;
+        bool persistent_structure_ = false;
+        bool names_changed_ = false;
+
+    public:
+        FlattenerImplementation() = default;
+
+        FlattenerImplementation(const FlattenerImplementation &other)
+        {
+            persistent_structure_ = other.persistent_structure_;
+            for (const std::unique_ptr<Element> &element : other.elements_)
+            {
+                elements_.push_back(std::make_unique<Element>(element->id_, persistent_structure_));
+            }
+        }
+
+        void add(const std::string &id)
+        {
+            std::size_t collisions = 0;
+            for (const std::unique_ptr<Element> &element : elements_)
+            {
+                if (element->id_ == id or 0 == element->id_.rfind(id + "_intrometry", 0))
+                {
+                    ++collisions;
+                }
+            }
+            elements_.push_back(std::make_unique<Element>(
+                    0 == collisions ? id : id + "_intrometry" + std::to_string(collisions), persistent_structure_));
+        }
+
+        void flatten(const std::size_t index, const ariles2::DefaultBase &source)
+        {
+            Element &element = *elements_[index];
+
+            // names of persistent sources are generated only in the first pass
+            ariles2::apply(element.writer_, source, element.id_, element.writer_parameters_);
+            if (element.data_->finalize(persistent_structure_))
+            {
+                if (persistent_structure_)
+                {
+                    // structure has changed, traverse again to generate names
+                    ariles2::apply(element.writer_, source, element.id_);
+                }
+                names_changed_ = true;
+            }
+        }
+
+        const Sample &finalize()
+        {
+            if (names_changed_)
+            {
+                ++sample_.version_;
+                sample_.names_.clear();
+                for (const std::unique_ptr<Element> &element : elements_)
+                {
+                    const Sample &sample = element->data_->sample_;
+                    sample_.names_.insert(sample_.names_.end(), sample.names_.begin(), sample.names_.end());
+                }
+                sample_.values_.resize(sample_.names_.size());
+                names_changed_ = false;
+            }
+
+            std::vector<double>::iterator value_it = sample_.values_.begin();
+            for (const std::unique_ptr<Element> &element : elements_)
+            {
+                const Sample &sample = element->data_->sample_;
+                value_it = std::copy(sample.values_.begin(), sample.values_.end(), value_it);
+            }
+
+            return (sample_);
+        }
+    };
+
+
+    Flattener::Flattener() : pimpl_(std::make_unique<FlattenerImplementation>())
+    {
+    }
+
+    Flattener::Flattener(const Flattener &other) : pimpl_(std::make_unique<FlattenerImplementation>(*other.pimpl_))
+    {
+    }
+
+    Flattener &Flattener::operator=(const Flattener &other)
+    {
+        if (this != &other)
+        {
+            pimpl_ = std::make_unique<FlattenerImplementation>(*other.pimpl_);
+        }
+        return (*this);
+    }
+
+    Flattener::Flattener(Flattener &&) noexcept = default;
+    Flattener &Flattener::operator=(Flattener &&) noexcept = default;
+    Flattener::~Flattener() = default;
+
+
+    void Flattener::reset(const bool persistent_structure)
+    {
+        pimpl_ = std::make_unique<FlattenerImplementation>();
+        pimpl_->persistent_structure_ = persistent_structure;
+    }
+
+    void Flattener::add(const std::string &id)
+    {
+        pimpl_->add(id);
+    }
+
+    void Flattener::flatten(const std::size_t index, const ariles2::DefaultBase &source)
+    {
+        pimpl_->flatten(index, source);
+    }
+
+    const Sample &Flattener::finalize()
+    {
+        return (pimpl_->finalize());
+    }
+}  // namespace intrometry::combo
@@ -0,0 +1,62 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <ariles2/visitors/namevalue2.h>
+
+#include "intrometry/backend/utils.h"
+
+
+namespace intrometry::backend
+{
+    /// Namevalue2 container that writes to intrometry::Sample
+    class SampleContainer : public ariles2::namevalue2::NameValueContainer
+    {
+    public:
+        intrometry::Sample sample_;
+        StructureTracker structure_;
+
+    public:
+        /// @return true if names have changed
+        bool finalize(const bool persistent_structure)
+        {
+            const bool names_changed = structure_.update(sample_.names_, persistent_structure);
+            if (names_changed)
+            {
+                ++sample_.version_;
+            }
+
+            return (names_changed);
+        }
+
+        std::string &name(const std::size_t index)
+        {
+            return (sample_.names_[index]);
+        }
+        double &value(const std::size_t index)
+        {
+            return (sample_.values_[index]);
+        }
+
+        void reserve(const std::size_t size)
+        {
+            sample_.names_.reserve(size);
+            sample_.values_.reserve(size);
+        }
+        [[nodiscard]] std::size_t size() const
+        {
+            return (sample_.names_.size());
+        }
+        void resize(const std::size_t size)
+        {
+            sample_.names_.resize(size);
+            sample_.values_.resize(size);
+        }
+    };
+}  // namespace intrometry::backend
@@ -0,0 +1,549 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <atomic>
+#include <deque>
+
+#include "intrometry/backend/utils.h"
+#include "intrometry/tee/sink.h"
+#include "sample_container.h"
+
+
+namespace
+{
+    class WriterWrapper
+    {
+    public:
+        using Outputs = std::vector<std::pair<std::shared_ptr<intrometry::Sink>, intrometry::SourceHandle>>;
+
+    public:
+        const std::string id_;  // NOLINT
+        ariles2::namevalue2::Writer::Parameters writer_parameters_;
+        std::shared_ptr<intrometry::backend::SampleContainer> data_;
+        ariles2::namevalue2::Writer writer_;
+
+        std::mutex mutex_;
+        // set when the source is assigned to sinks
+        std::atomic<bool> ready_;
+
+        // sinks and handles of the source in these sinks
+        Outputs outputs_;
+
+        intrometry::backend::SourceCounters counters_;
+
+    public:
+        /// @param[in] asynchronous defer assignment to sinks, see connect()
+        WriterWrapper(
+                const ariles2::DefaultBase &source,
+                std::string id,
+                const std::string &assigned_id,
+                const intrometry::Source::Parameters &parameters,
+                const std::vector<std::shared_ptr<intrometry::Sink>> &sinks,
+                const bool asynchronous)
+          : id_(std::move(id)), data_(std::make_shared<intrometry::backend::SampleContainer>()), writer_(data_)
+        {
+            writer_parameters_ = writer_.getDefaultParameters();
+            if (parameters.persistent_structure_)
+            {
+                writer_parameters_.persistent_structure_ = true;
+            }
+
+            if (asynchronous)
+            {
+                // memory is allocated by the first write
+                ready_ = false;
+            }
+            else
+            {
+                for (const std::shared_ptr<intrometry::Sink> &sink : sinks)
+                {
+                    intrometry::SourceHandle handle = sink->assign(assigned_id, source, getSinkParameters(parameters));
+                    if (handle.valid())
+                    {
+                        outputs_.emplace_back(sink, std::move(handle));
+                    }
+                }
+
+                // write to allocate memory and generate names
+                ariles2::apply(writer_, source, id_, writer_parameters_);
+                data_->finalize(writer_parameters_.persistent_structure_);
+                ready_ = true;
+            }
+        }
+
+
+        static intrometry::Source::Parameters getSinkParameters(const intrometry::Source::Parameters &parameters)
+        {
+            // samples are passed to sinks, which must not copy sources
+            intrometry::Source::Parameters sink_parameters = parameters;
+            sink_parameters.copy_.reset();
+            return (sink_parameters);
+        }
+
+
+        /// Deferred assignment: the source is assigned to sinks on behalf of an empty source with a unique id
+        void connect(
+                const std::vector<std::shared_ptr<intrometry::Sink>> &sinks,
+                const intrometry::SampleSource &placeholder,
+                const intrometry::Source::Parameters &parameters)
+        {
+            Outputs outputs;
+            for (const std::shared_ptr<intrometry::Sink> &sink : sinks)
+            {
+                intrometry::SourceHandle handle = sink->assign(id_, placeholder, getSinkParameters(parameters));
+                if (handle.valid())
+                {
+                    outputs.emplace_back(sink, std::move(handle));
+                }
+            }
+
+            const std::lock_guard lock(mutex_);
+            outputs_ = std::move(outputs);
+            ready_.store(true, std::memory_order_release);
+        }
+
+
+        /// @param[in] timestamp nanoseconds since epoch, 0 -- sinks use their clocks
+        /// @return false if the source is not assigned to sinks yet
+        bool write(const ariles2::DefaultBase &source, const uint64_t timestamp)
+        {
+            if (not ready_.load(std::memory_order_acquire))
+            {
+                return (false);
+            }
+
+            if (mutex_.try_lock())
+            {
+                // names of persistent sources are generated only in the first pass
+                ariles2::apply(writer_, source, id_, writer_parameters_);
+                if (data_->finalize(writer_parameters_.persistent_structure_)
+                    and writer_parameters_.persistent_structure_)
+                {
+                    // structure has changed, traverse again to generate names
+                    ariles2::apply(writer_, source, id_);
+                }
+                forward(data_->sample_, timestamp);
+                intrometry::backend::increment(counters_.accepted_);
+                mutex_.unlock();
+            }
+            else
+            {
+                intrometry::backend::increment(counters_.dropped_busy_);
+            }
+            return (true);
+        }
+
+
+        /// @return false if the source is not assigned to sinks yet
+        bool write(const intrometry::Sample &sample, const uint64_t timestamp)
+        {
+            if (not ready_.load(std::memory_order_acquire))
+            {
+                return (false);
+            }
+
+            if (mutex_.try_lock())
+            {
+                forward(sample, timestamp);
+                intrometry::backend::increment(counters_.accepted_);
+                mutex_.unlock();
+            }
+            else
+            {
+                intrometry::backend::increment(counters_.dropped_busy_);
+            }
+            return (true);
+        }
+
+
+        void getStatistics(intrometry::SourceStatistics &statistics) const
+        {
+            counters_.get(statistics);
+            statistics.id_ = id_;
+        }
+
+    protected:
+        void forward(const intrometry::Sample &sample, const uint64_t timestamp)
+        {
+            for (const std::pair<std::shared_ptr<intrometry::Sink>, intrometry::SourceHandle> &output : outputs_)
+            {
+                output.first->write(output.second, sample, timestamp);
+            }
+        }
+    };
+}  // namespace
+
+
+namespace intrometry::tee::sink
+{
+    Parameters::Parameters(std::vector<std::shared_ptr<intrometry::Sink>> sinks) : sinks_(std::move(sinks))
+    {
+        asynchronous_ = false;
+    }
+
+    Parameters &Parameters::sink(std::shared_ptr<intrometry::Sink> value)
+    {
+        sinks_.push_back(std::move(value));
+        return (*this);
+    }
+
+    Parameters &Parameters::asynchronous(const bool value)
+    {
+        asynchronous_ = value;
+        return (*this);
+    }
+}  // namespace intrometry::tee::sink
+
+
+namespace intrometry::tee::sink
+{
+    class Implementation
+    {
+    protected:
+        const std::vector<std::shared_ptr<intrometry::Sink>> sinks_;  // NOLINT
+        const bool asynchronous_;                                     // NOLINT
+        const intrometry::SampleSource placeholder_;                  // NOLINT
+
+        // asynchronous mode: initialization, assignments, and retractions are performed by the worker thread
+        std::mutex requests_mutex_;
+        std::condition_variable requests_condition_;
+        std::deque<std::function<void()>> requests_;
+        std::atomic<std::size_t> pending_;
+        std::atomic<bool> initialized_;
+        std::atomic<bool> failed_;
+        bool stop_;
+        std::thread worker_;
+
+    public:
+        intrometry::backend::SourceContainer<WriterWrapper> sources_;
+        intrometry::backend::SinkCounters counters_;
+
+    public:
+        explicit Implementation(const Parameters &parameters)
+          : sinks_(parameters.sinks_)
+          , asynchronous_(parameters.asynchronous_)
+          , pending_(0)
+          , initialized_(not parameters.asynchronous_)
+          , failed_(false)
+          , stop_(false)
+        {
+            if (asynchronous_)
+            {
+                enqueue(
+                        [this]()
+                        {
+                            for (const std::shared_ptr<intrometry::Sink> &sink : sinks_)
+                            {
+                                if (not sink->initialize())
+                                {
+                                    fail();
+                                }
+                            }
+                            initialized_.store(true, std::memory_order_release);
+                        });
+                worker_ = std::thread(&Implementation::spin, this);
+            }
+        }
+
+        ~Implementation()
+        {
+            if (worker_.joinable())
+            {
+                {
+                    const std::lock_guard lock(requests_mutex_);
+                    stop_ = true;
+                }
+                requests_condition_.notify_one();
+                worker_.join();
+            }
+        }
+
+
+        /// @return true if sinks are initialized with all pending assignments
+        [[nodiscard]] bool ready() const
+        {
+            return (0 == pending_.load(std::memory_order_acquire) and not failed());
+        }
+
+        /// @return true if initialization of a sink has failed
+        [[nodiscard]] bool failed() const
+        {
+            return (failed_.load(std::memory_order_acquire));
+        }
+
+        void fail()
+        {
+            failed_.store(true, std::memory_order_release);
+        }
+
+
+        void enqueue(std::function<void()> request)
+        {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            {
+                const std::lock_guard lock(requests_mutex_);
+                requests_.push_back(std::move(request));
+            }
+            requests_condition_.notify_one();
+        }
+
+
+        void spin()
+        {
+            for (;;)
+            {
+                std::function<void()> request;
+                {
+                    std::unique_lock lock(requests_mutex_);
+                    requests_condition_.wait(lock, [this]() { return (stop_ or not requests_.empty()); });
+                    if (stop_)
+                    {
+                        return;
+                    }
+                    request = std::move(requests_.front());
+                    requests_.pop_front();
+                }
+                request();
+                pending_.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+
+        std::shared_ptr<WriterWrapper> assign(
+                const std::string &id,
+                const ariles2::DefaultBase &source,
+                const Source::Parameters &parameters)
+        {
+            const std::shared_ptr<WriterWrapper> writer =
+                    sources_.tryEmplace(id, source, id, parameters, sinks_, asynchronous_);
+            if (asynchronous_ and not writer->ready_.load(std::memory_order_acquire))
+            {
+                // the source itself may be modified concurrently and is not used by the worker
+                enqueue([this, writer, parameters]() { writer->connect(sinks_, placeholder_, parameters); });
+            }
+            return (writer);
+        }
+
+
+        void retract(const std::string &id, const ariles2::DefaultBase &source)
+        {
+            const std::shared_ptr<WriterWrapper> writer = sources_.erase(id, source);
+            if (not asynchronous_)
+            {
+                for (const std::shared_ptr<intrometry::Sink> &sink : sinks_)
+                {
+                    sink->retract(id, source);
+                }
+            }
+            else if (writer)
+            {
+                // performed after the pending assignment
+                enqueue(
+                        [this, child_id = writer->id_]()
+                        {
+                            for (const std::shared_ptr<intrometry::Sink> &sink : sinks_)
+                            {
+                                sink->retract(child_id, placeholder_);
+                            }
+                        });
+            }
+        }
+
+
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+        {
+            bool accepted = false;
+            sources_.write(
+                    id,
+                    source,
+                    [&accepted, &source, &timestamp](WriterWrapper &writer)
+                    { accepted = writer.write(source, timestamp); });
+            if (not accepted)
+            {
+                intrometry::backend::increment(counters_.unassigned_);
+            }
+        }
+
+
+        template <class t_Source>
+        void write(const SourceHandle &handle, const t_Source &source, const uint64_t timestamp)
+        {
+            const std::shared_ptr<WriterWrapper> writer = handle.lock<WriterWrapper>(this);
+            if (not writer or not writer->write(source, timestamp))
+            {
+                intrometry::backend::increment(counters_.unassigned_);
+            }
+        }
+
+
+        void flush()
+        {
+            // sinks must not be used concurrently with their initialization
+            if (initialized_.load(std::memory_order_acquire))
+            {
+                for (const std::shared_ptr<intrometry::Sink> &sink : sinks_)
+                {
+                    sink->flush();
+                }
+            }
+        }
+
+
+        /// Statistics of all sinks are summed, sources of all sinks are listed
+        void getStatistics(SinkStatistics &statistics)
+        {
+            counters_.get(statistics);
+
+            uint64_t dropped_busy = 0;
+            sources_.visit(
+                    [&dropped_busy](const WriterWrapper &writer)
+                    {
+                        intrometry::SourceStatistics source_statistics;
+                        writer.getStatistics(source_statistics);
+                        dropped_busy += source_statistics.dropped_busy_;
+                    });
+
+            statistics.sources_.clear();
+            for (const std::shared_ptr<intrometry::Sink> &sink : sinks_)
+            {
+                if (not initialized_.load(std::memory_order_acquire))
+                {
+                    break;
+                }
+                const SinkStatistics sink_statistics = sink->statistics();
+
+                statistics.unassigned_ += sink_statistics.unassigned_;
+                statistics.flush_ticks_ += sink_statistics.flush_ticks_;
+                statistics.flush_overruns_ += sink_statistics.flush_overruns_;
+                statistics.io_stalls_ += sink_statistics.io_stalls_;
+                statistics.unsubscribed_ += sink_statistics.unsubscribed_;
+                statistics.thread_errors_ += sink_statistics.thread_errors_;
+
+                statistics.total_ += sink_statistics.total_;
+
+                statistics.sources_.insert(
+                        statistics.sources_.end(), sink_statistics.sources_.begin(), sink_statistics.sources_.end());
+            }
+            // writes dropped by the tee never reach the sinks
+            statistics.total_.dropped_busy_ += dropped_busy;
+        }
+    };
+}  // namespace intrometry::tee::sink
+
+
+namespace intrometry::tee
+{
+    Sink::~Sink() = default;
+
+
+    bool Sink::initialize()
+    {
+        if (parameters_.asynchronous_)
+        {
+            // sinks are initialized by the worker thread
+            make_pimpl(parameters_);
+            return (true);
+        }
+
+        bool result = true;
+        for (const std::shared_ptr<intrometry::Sink> &sink : parameters_.sinks_)
+        {
+            if (not sink->initialize())
+            {
+                result = false;
+            }
+        }
+        make_pimpl(parameters_);
+        if (not result)
+        {
+            pimpl_->fail();
+        }
+        return (result);
+    }
+
+
+    SourceHandle Sink::assign(
+            const std::string &id,
+            const ariles2::DefaultBase &source,
+            const Source::Parameters &parameters)
+    {
+        if (pimpl_)
+        {
+            return (SourceHandle(pimpl_.get(), pimpl_->assign(id, source, parameters)));
+        }
+        return (SourceHandle());
+    }
+
+
+    void Sink::retract(const std::string &id, const ariles2::DefaultBase &source)
+    {
+        if (pimpl_)
+        {
+            pimpl_->retract(id, source);
+        }
+    }
+
+
+    void Sink::write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(id, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, sample, timestamp);
+        }
+    }
+
+
+    void Sink::flush()
+    {
+        if (pimpl_)
+        {
+            pimpl_->flush();
+        }
+    }
+
+
+    bool Sink::ready() const
+    {
+        return (pimpl_ and pimpl_->ready());
+    }
+
+
+    bool Sink::failed() const
+    {
+        return (pimpl_ and pimpl_->failed());
+    }
+
+
+    SinkStatistics Sink::statistics() const
+    {
+        SinkStatistics result;
+        if (pimpl_)
+        {
+            pimpl_->getStatistics(result);
+        }
+        return (result);
+    }
+}  // namespace intrometry::tee
@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <filesystem>
+#include <vector>
 
 #include <intrometry/sink.h>
 #include <intrometry/backend/utils.h>
@@ -40,6 +42,71 @@ namespace intrometry::pjmsg_mcap
                 ZSTD
             } compression_;
 
+            /// publish sink statistics as an extra source once per second
+            bool statistics_;
+
+            /// clock used to timestamp data written without explicit timestamps
+            Clock clock_;
+
+            /// placement of the sink thread (and other threads spawned by the sink)
+            ThreadParameters thread_;
+
+            /**
+             * size of the process-wide pool of threads shared by all sinks of
+             * this backend that enable it, sinks are flushed at their own
+             * rates; the pool is created by the first sink with its `thread`
+             * parameters and stopped with the last one. 0 -- dedicated
+             * thread.
+             */
+            std::size_t shared_threads_;
+
+            /**
+             * number of preallocated messages in the queue of a dedicated I/O
+             * thread, which performs compression and writing to the file;
+             * messages that do not fit in the queue are counted as I/O stalls;
+             * 0 -- write in the flushing thread
+             */
+            std::size_t io_queue_size_;
+
+            /**
+             * file rotation: a new file is started when the current one
+             * exceeds the given size in bytes or duration, 0 -- no limit.
+             * The size is estimated using the number of written values.
+             * Files are preallocated to the maximum size, the next file is
+             * opened in background.
+             */
+            uint64_t max_file_size_;
+            std::chrono::seconds max_file_duration_;
+            /// maximum number of retained files, older files are removed, 0 -- no limit
+            std::size_t max_files_;
+
+            /**
+             * flight recorder mode: the last `history_duration * rate`
+             * flushed messages of each source are kept in memory and written
+             * to a new file only on snapshot(), 0 -- disabled. The history
+             * spans `history_duration` seconds only if each periodic flush
+             * publishes a sample: sources that are written less often and
+             * explicit flush() calls change the covered time span. Messages
+             * are preallocated using the structure of the source at
+             * assignment and kept uncompressed, i.e., memory usage is about
+             * `history_duration * rate` times the size of names and values of
+             * all sources; the `compression` parameter applies to snapshot
+             * files. I/O queue and rotation parameters are ignored in this
+             * mode.
+             */
+            std::chrono::seconds history_duration_;
+            /**
+             * signals that trigger snapshots in flight recorder mode, e.g.,
+             * SIGUSR1; on fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL,
+             * SIGABRT) the handler waits for the snapshot for up to 3 seconds
+             * and then raises the signal again with the previous handler;
+             * previous handlers of other signals are called after requesting
+             * the snapshot unless they are default or ignored. Previous
+             * actions are restored when the last sink in flight recorder mode
+             * is destroyed.
+             */
+            std::vector<int> snapshot_signals_;
+
 
         public:
             // cppcheck-suppress noExplicitConstructor
@@ -51,6 +118,16 @@ namespace intrometry::pjmsg_mcap
             Parameters &id(const std::string &value);
             Parameters &directory(const std::filesystem::path &value);
             Parameters &compression(const Compression value);
+            Parameters &statistics(const bool value);
+            Parameters &clock(const Clock &value);
+            Parameters &thread(const ThreadParameters &value);
+            Parameters &shared_threads(const std::size_t value);
+            Parameters &io_queue_size(const std::size_t value);
+            Parameters &max_file_size(const uint64_t value);
+            Parameters &max_file_duration(const std::chrono::seconds value);
+            Parameters &max_files(const std::size_t value);
+            Parameters &history_duration(const std::chrono::seconds value);
+            Parameters &snapshot_signals(const std::vector<int> &value);
         };
 
         class Implementation;
@@ -70,12 +147,22 @@ namespace intrometry::pjmsg_mcap
         ~Sink();
 
         bool initialize();
-        void assign(
+        SourceHandle assign(
                 const std::string &id,
                 const ariles2::DefaultBase &source,
                 const Source::Parameters &parameters = Source::Parameters());
         void retract(const std::string &id, const ariles2::DefaultBase &source);
         void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp = 0);
         void flush();
+        [[nodiscard]] SinkStatistics statistics() const;
+
+        /**
+         * Request writing of the in-memory history to a new file in flight
+         * recorder mode, the file is written asynchronously by the sink thread.
+         * @return false if flight recorder mode is disabled
+         */
+        bool snapshot();
     };
 }  // namespace intrometry::pjmsg_mcap
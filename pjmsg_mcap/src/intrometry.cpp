@@ -8,9 +8,22 @@
 
 
 #include <ariles2/visitors/namevalue2.h>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <ctime>
+#include <deque>
+#include <iomanip>
+#include <thread>
 #include <thread_supervisor/supervisor.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <pjmsg_mcap_wrapper/writer.h>
 
 #include "intrometry/intrometry.h"
@@ -23,21 +36,194 @@ namespace
     std::string getDateString()
     {
         const std::time_t date_now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm date_tm = {};
         std::stringstream date_stream;
-        // thread-unsafe
-        date_stream << std::put_time(std::gmtime(&date_now), "%Y%m%d_%H%M%S");  // NOLINT
+        // files may be opened in a background thread
+        date_stream << std::put_time(gmtime_r(&date_now, &date_tm), "%Y%m%d_%H%M%S");
 
         return (date_stream.str());
     }
 
 
+    /**
+     * Process-wide state of snapshot signals. Signal handlers only access
+     * lock-free atomics and call async-signal-safe functions, snapshots are
+     * written by sink threads. Handlers are shared by sinks in history mode,
+     * previous actions are restored when the last of them is destroyed.
+     * Previous actions are read by handlers without locking: they are
+     * stored before the handler is installed and only when no handler is
+     * reading them.
+     */
+    class SnapshotSignals
+    {
+    public:
+        // number of raised signals
+        std::atomic<uint64_t> requested_;
+        // the last request served by any sink
+        std::atomic<uint64_t> completed_;
+        // number of sinks in history mode
+        std::atomic<std::size_t> sinks_;
+        // number of handlers reading previous actions
+        std::atomic<std::size_t> readers_;
+
+    protected:
+        std::mutex mutex_;
+        std::array<struct sigaction, NSIG> previous_;
+        std::array<bool, NSIG> installed_;
+
+    protected:
+        static bool isFault(const int signal)
+        {
+            return (SIGSEGV == signal or SIGBUS == signal or SIGFPE == signal or SIGILL == signal
+                    or SIGABRT == signal);
+        }
+
+        static void handle(int signal, siginfo_t *info, void *context);
+
+        bool install(const int signal)
+        {
+            if (signal <= 0 or signal >= NSIG)
+            {
+                return (false);
+            }
+
+            if (not installed_[signal])
+            {
+                struct sigaction previous = {};
+                if (0 != sigaction(signal, nullptr, &previous))
+                {
+                    return (false);
+                }
+                // handlers invoked before the previous release() may still be running
+                while (readers_.load() > 0)
+                {
+                    std::this_thread::yield();
+                }
+                previous_[signal] = previous;
+
+                struct sigaction action = {};
+                action.sa_sigaction = &SnapshotSignals::handle;
+                sigemptyset(&action.sa_mask);
+                // fault handlers are called once, the signal is raised again with the previous handler
+                action.sa_flags = SA_SIGINFO | (isFault(signal) ? SA_RESETHAND : SA_RESTART);
+                if (0 != sigaction(signal, &action, nullptr))
+                {
+                    return (false);
+                }
+                installed_[signal] = true;
+            }
+            return (true);
+        }
+
+    public:
+        SnapshotSignals()
+        {
+            static_assert(std::atomic<uint64_t>::is_always_lock_free);
+            static_assert(std::atomic<std::size_t>::is_always_lock_free);
+
+            requested_ = 0;
+            completed_ = 0;
+            sinks_ = 0;
+            readers_ = 0;
+            previous_ = {};
+            installed_ = {};
+        }
+
+        /// Register a sink in history mode, handlers are shared by all sinks
+        template <class t_Log>
+        void acquire(const std::vector<int> &signals, const t_Log &log)
+        {
+            const std::lock_guard lock(mutex_);
+            sinks_.fetch_add(1);
+            for (const int signal : signals)
+            {
+                if (not install(signal))
+                {
+                    log(signal);
+                }
+            }
+        }
+
+        /// Unregister a sink, the last one restores previous signal actions
+        void release()
+        {
+            const std::lock_guard lock(mutex_);
+            if (1 == sinks_.fetch_sub(1))
+            {
+                for (std::size_t signal = 1; signal < installed_.size(); ++signal)
+                {
+                    if (installed_[signal])
+                    {
+                        sigaction(static_cast<int>(signal), &previous_[signal], nullptr);
+                        installed_[signal] = false;
+                    }
+                }
+            }
+        }
+
+        void complete(const uint64_t request)
+        {
+            uint64_t completed = completed_.load();
+            while (completed < request and not completed_.compare_exchange_weak(completed, request))
+            {
+            }
+        }
+    };
+
+    SnapshotSignals snapshot_signals;  // NOLINT
+
+
+    void SnapshotSignals::handle(const int signal, siginfo_t *info, void *context)
+    {
+        const int saved_errno = errno;
+
+        const uint64_t request = snapshot_signals.requested_.fetch_add(1) + 1;
+        // a copy, previous actions may be replaced after release()
+        snapshot_signals.readers_.fetch_add(1);
+        const struct sigaction previous = snapshot_signals.previous_[signal];
+        snapshot_signals.readers_.fetch_sub(1);
+        if (isFault(signal))
+        {
+            // give sink threads a chance to write snapshots, the process is terminated afterwards
+            constexpr std::size_t attempts = 300;
+            const struct timespec period = { 0, 10000000 };  // NOLINT, 10ms
+            for (std::size_t i = 0; i < attempts and snapshot_signals.sinks_.load() > 0
+                                    and snapshot_signals.completed_.load() < request;
+                 ++i)
+            {
+                nanosleep(&period, nullptr);
+            }
+            sigaction(signal, &previous, nullptr);
+            raise(signal);
+        }
+        else if (0 != (previous.sa_flags & SA_SIGINFO))
+        {
+            previous.sa_sigaction(signal, info, context);
+        }
+        else if (SIG_DFL != previous.sa_handler and SIG_IGN != previous.sa_handler)
+        {
+            // default actions, e.g., termination, would prevent the snapshot
+            previous.sa_handler(signal);
+        }
+
+        errno = saved_errno;
+    }
+
+
     class NameValueContainer : public ariles2::namevalue2::NameValueContainer
     {
     public:
-        std::size_t previous_size_ = 0;
+        intrometry::backend::StructureTracker structure_;
+        uint32_t version_ = 0;
         std::shared_ptr<pjmsg_mcap_wrapper::Message> message_in_;
         std::shared_ptr<pjmsg_mcap_wrapper::Message> message_out_;
 
+        // stamps of messages, raw stamps are clock readings converted by the consumer
+        uint64_t stamp_in_ = 0;
+        uint64_t stamp_out_ = 0;
+        bool raw_in_ = false;
+        bool raw_out_ = false;
+
 
     public:
         NameValueContainer()
@@ -53,110 +239,1048 @@ namespace
                 message_out_->reset(*message_in_);
             }
             std::swap(message_out_, message_in_);
+            std::swap(stamp_out_, stamp_in_);
+            std::swap(raw_out_, raw_in_);
         }
 
-        void finalize(const bool persistent_structure, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        /// @return true if names have changed
+        bool finalize(const bool persistent_structure, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
         {
             message_in_->setStamp(timestamp);
+            stamp_in_ = timestamp;
+            raw_in_ = false;
+
+            const bool names_changed = structure_.update(message_in_->names(), persistent_structure);
+            if (names_changed)
+            {
+                // fetch_add atomically returns the old value and increments,
+                // preventing concurrent writes from getting the same version.
+                version_ = names_version.fetch_add(1);
+            }
+            message_in_->setVersion(version_);
+
+            return (names_changed);
+        }
+
+        std::string &name(const std::size_t index)
+        {
+            return (message_in_->name(index));
+        }
+
+        double &value(const std::size_t index)
+        {
+            return (message_in_->value(index));
+        }
+
+        void reserve(const std::size_t size)
+        {
+            message_in_->reserve(size);
+        }
+
+        void resize(const std::size_t size)
+        {
+            message_in_->resize(size);
+        }
+
+        [[nodiscard]] std::size_t size() const
+        {
+            return (message_in_->size());
+        }
+    };
+}  // namespace
+
+
+namespace
+{
+    /**
+     * Single producer single consumer ring of preallocated messages. One slot
+     * is always kept free: it is filled by the producer before being pushed.
+     * Pushed slots belong to the consumer, names of the last pushed message
+     * are kept in a separate message owned by the producer, which is used
+     * to fill stale slots.
+     */
+    class MessageRing
+    {
+    public:
+        class Slot
+        {
+        public:
+            std::shared_ptr<pjmsg_mcap_wrapper::Message> message_;
+            // raw stamps are clock readings converted by the consumer
+            uint64_t stamp_ = 0;
+            bool raw_ = false;
+        };
+
+    protected:
+        std::vector<Slot> slots_;
+        std::shared_ptr<pjmsg_mcap_wrapper::Message> names_;
+        // next slot to be filled by the producer
+        std::atomic<std::size_t> head_;
+        // next slot to be consumed
+        std::atomic<std::size_t> tail_;
+
+    protected:
+        [[nodiscard]] std::size_t next(const std::size_t index) const
+        {
+            return ((index + 1) % slots_.size());
+        }
+
+    public:
+        explicit MessageRing(const std::size_t size)
+        {
+            slots_.resize(size + 1);
+            for (Slot &slot : slots_)
+            {
+                slot.message_ = std::make_shared<pjmsg_mcap_wrapper::Message>();
+            }
+            names_ = std::make_shared<pjmsg_mcap_wrapper::Message>();
+            head_ = 0;
+            tail_ = 0;
+        }
+
+        /// preallocate all slots using the given message as a template
+        void reserve(const pjmsg_mcap_wrapper::Message &message)
+        {
+            for (Slot &slot : slots_)
+            {
+                if (slot.message_.get() != &message)
+                {
+                    slot.message_->reset(message);
+                }
+            }
+            names_->reset(message);
+        }
+
+        // producer
+
+        /// names are not regenerated on every write, they are copied to the slot if stale
+        [[nodiscard]] Slot &back()
+        {
+            Slot &slot = slots_[head_.load(std::memory_order_relaxed)];
+            if (slot.message_->getVersion() != names_->getVersion())
+            {
+                slot.message_->reset(*names_);
+            }
+            return (slot);
+        }
+
+        [[nodiscard]] bool full() const
+        {
+            return (next(head_.load(std::memory_order_relaxed)) == tail_.load(std::memory_order_acquire));
+        }
+
+        void push()
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            const pjmsg_mcap_wrapper::Message &message = *slots_[head].message_;
+            if (message.getVersion() != names_->getVersion())
+            {
+                names_->reset(message);
+            }
+            head_.store(next(head), std::memory_order_release);
+        }
+
+        // consumer
+
+        [[nodiscard]] bool empty() const
+        {
+            return (tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire));
+        }
+
+        /// visitor returns false to stop draining, the current slot is retained in this case
+        template <class t_Visitor>
+        void drain(t_Visitor &&visitor)
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            const std::size_t head = head_.load(std::memory_order_acquire);
+
+            while (tail != head and visitor(slots_[tail]))
+            {
+                tail = next(tail);
+                tail_.store(tail, std::memory_order_release);
+            }
+        }
+    };
+
+
+    /// Reserve disk space without changing the file size, @return reserved size
+    uint64_t preallocate(const std::filesystem::path &path, const uint64_t size)
+    {
+        // a separate descriptor, the file is kept open by the MCAP writer
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);  // NOLINT
+        if (fd < 0)
+        {
+            return (0);
+        }
+        const bool result = (0 == ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)));
+        ::close(fd);
+        return (result ? size : 0);
+    }
+
+    /// Release reserved disk space past the end of the file
+    void trim(const std::filesystem::path &path, const uint64_t preallocated)
+    {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);  // NOLINT
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat file_stat = {};
+        if (0 == ::fstat(fd, &file_stat) and static_cast<uint64_t>(file_stat.st_size) < preallocated)
+        {
+            ::fallocate(
+                    fd,
+                    FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,  // NOLINT
+                    file_stat.st_size,
+                    static_cast<off_t>(preallocated) - file_stat.st_size);
+        }
+        ::close(fd);
+    }
+
+
+    void configureThread(const intrometry::ThreadParameters &parameters, tut::thread::Supervisor<> &thread_supervisor)
+    {
+        const std::string errors = intrometry::backend::configureThread(parameters);
+        if (not errors.empty())
+        {
+            thread_supervisor.log("Could not apply thread parameters: ", errors);
+        }
+    }
+
+
+    /**
+     * Sequence of MCAP files: when rotation is enabled, the next file is
+     * opened and preallocated in a background thread, which also closes
+     * full files and removes old files, so that switching between files
+     * costs the writing thread only a pointer swap.
+     */
+    class FileSequence
+    {
+    public:
+        class Parameters
+        {
+        public:
+            std::function<std::filesystem::path(std::size_t)> filename_;
+            std::string topic_prefix_;
+            pjmsg_mcap_wrapper::Writer::Parameters writer_parameters_;
+            uint64_t max_file_size_ = 0;
+            std::chrono::seconds max_file_duration_ = std::chrono::seconds(0);
+            std::size_t max_files_ = 0;
+            intrometry::ThreadParameters thread_parameters_;
+        };
+
+    protected:
+        class File
+        {
+        public:
+            std::unique_ptr<pjmsg_mcap_wrapper::Writer> writer_;
+            std::filesystem::path path_;
+            uint64_t preallocated_ = 0;
+            std::chrono::time_point<std::chrono::steady_clock> opened_;
+            // estimated size: written values, names and compression are ignored
+            uint64_t bytes_ = 0;
+            // empty files are not rotated
+            bool written_ = false;
+        };
+
+    protected:
+        Parameters parameters_;
+        tut::thread::Supervisor<> &thread_supervisor_;
+
+        // accessed by the writing thread only
+        File current_;
+
+        // accessed by the background thread only
+        std::size_t index_;
+        std::deque<std::filesystem::path> retained_;
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::unique_ptr<File> next_;
+        std::vector<File> closing_;
+        bool stop_;
+        std::thread thread_;
+
+    protected:
+        [[nodiscard]] bool rotation() const
+        {
+            return (parameters_.max_file_size_ > 0 or parameters_.max_file_duration_.count() > 0);
+        }
+
+        std::unique_ptr<File> open()
+        {
+            std::unique_ptr<File> file = std::make_unique<File>();
+            file->path_ = parameters_.filename_(index_++);
+            file->writer_ = std::make_unique<pjmsg_mcap_wrapper::Writer>();
+            file->writer_->initialize(file->path_, parameters_.topic_prefix_, parameters_.writer_parameters_);
+            if (parameters_.max_file_size_ > 0)
+            {
+                file->preallocated_ = preallocate(file->path_, parameters_.max_file_size_);
+            }
+            return (file);
+        }
+
+        void close(File &file)
+        {
+            // finalizes the file
+            file.writer_.reset();
+            if (file.preallocated_ > 0)
+            {
+                trim(file.path_, file.preallocated_);
+            }
+
+            retained_.push_back(file.path_);
+            // the current file counts too
+            while (parameters_.max_files_ > 0 and retained_.size() + 1 > parameters_.max_files_)
+            {
+                std::error_code error_code;
+                std::filesystem::remove(retained_.front(), error_code);
+                retained_.pop_front();
+            }
+        }
+
+        void spin()
+        {
+            configureThread(parameters_.thread_parameters_, thread_supervisor_);
+
+            std::unique_lock lock(mutex_);
+            for (;;)
+            {
+                condition_.wait(lock, [this]() { return (stop_ or not closing_.empty() or not next_); });
+
+                std::vector<File> closing;
+                std::swap(closing, closing_);
+                const bool stop = stop_;
+                const bool open_next = (not stop and not next_);
+                lock.unlock();
+
+                for (File &file : closing)
+                {
+                    close(file);
+                }
+
+                if (stop)
+                {
+                    return;
+                }
+
+                std::unique_ptr<File> next;
+                if (open_next)
+                {
+                    try
+                    {
+                        next = open();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        thread_supervisor_.log("Opening of the next file failed: ", e.what());
+                    }
+                }
+
+                lock.lock();
+                if (next)
+                {
+                    next_ = std::move(next);
+                }
+                else if (open_next)
+                {
+                    // retry later
+                    condition_.wait_for(lock, std::chrono::seconds(1), [this]() { return (stop_); });
+                }
+            }
+        }
+
+    public:
+        explicit FileSequence(tut::thread::Supervisor<> &thread_supervisor) : thread_supervisor_(thread_supervisor)
+        {
+            index_ = 0;
+            stop_ = false;
+        }
+
+        ~FileSequence()
+        {
+            stop();
+        }
+
+        FileSequence(const FileSequence &) = delete;
+        FileSequence &operator=(const FileSequence &) = delete;
+
+        void initialize(const Parameters &parameters)
+        {
+            parameters_ = parameters;
+
+            std::unique_ptr<File> file = open();
+            current_ = std::move(*file);
+            current_.opened_ = std::chrono::steady_clock::now();
+
+            if (rotation())
+            {
+                thread_ = std::thread(&FileSequence::spin, this);
+            }
+        }
+
+        void write(const pjmsg_mcap_wrapper::Message &message)
+        {
+            current_.writer_->write(message);
+            current_.bytes_ += message.size() * sizeof(double);
+            current_.written_ = true;
+        }
+
+        /// Switch to the next file if the current one is full, never blocks
+        void rotate()
+        {
+            if (not rotation() or not current_.written_)
+            {
+                return;
+            }
+
+            const std::chrono::time_point<std::chrono::steady_clock> now = std::chrono::steady_clock::now();
+            bool full = (parameters_.max_file_duration_.count() > 0
+                         and now - current_.opened_ >= parameters_.max_file_duration_);
+            if (not full and parameters_.max_file_size_ > 0)
+            {
+                full = (current_.bytes_ >= parameters_.max_file_size_);
+            }
+
+            if (full)
+            {
+                std::unique_lock lock(mutex_, std::try_to_lock);
+                if (lock.owns_lock() and next_)
+                {
+                    closing_.push_back(std::move(current_));
+                    current_ = std::move(*next_);
+                    current_.opened_ = now;
+                    next_.reset();
+                    lock.unlock();
+                    condition_.notify_one();
+                }
+            }
+        }
+
+        /// Close all files, must be called after the last write
+        void stop()
+        {
+            if (thread_.joinable())
+            {
+                {
+                    const std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                condition_.notify_one();
+                thread_.join();
+
+                if (next_)
+                {
+                    // unused file
+                    const std::filesystem::path path = next_->path_;
+                    next_.reset();
+                    std::error_code error_code;
+                    std::filesystem::remove(path, error_code);
+                }
+            }
+
+            if (current_.writer_)
+            {
+                close(current_);
+            }
+        }
+    };
+
+
+    /**
+     * MCAP file output: messages are either written directly or copied to a
+     * bounded queue of preallocated messages, which is consumed by a
+     * dedicated I/O thread, so that flushing does not wait for compression
+     * and the file system.
+     */
+    class Output
+    {
+    protected:
+        FileSequence files_;
+        intrometry::backend::SinkCounters &counters_;
+        tut::thread::Supervisor<> &thread_supervisor_;
+
+        std::vector<std::shared_ptr<pjmsg_mcap_wrapper::Message>> queue_;
+        // next slot to be filled by producers
+        std::atomic<std::size_t> head_;
+        // next slot to be written to the file
+        std::atomic<std::size_t> tail_;
+        // flushing may be triggered by the user concurrently with the spinning thread
+        std::mutex push_mutex_;
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stop_;
+        std::thread thread_;
+
+    protected:
+        [[nodiscard]] std::size_t next(const std::size_t index) const
+        {
+            return ((index + 1) % queue_.size());
+        }
+
+        void spin(const intrometry::ThreadParameters &thread_parameters)
+        {
+            configureThread(thread_parameters, thread_supervisor_);
+
+            std::unique_lock lock(mutex_);
+            for (;;)
+            {
+                condition_.wait(
+                        lock,
+                        [this]()
+                        {
+                            return (stop_
+                                    or head_.load(std::memory_order_acquire)
+                                               != tail_.load(std::memory_order_relaxed));
+                        });
+                const bool stop = stop_;
+                lock.unlock();
+
+                std::size_t tail = tail_.load(std::memory_order_relaxed);
+                const std::size_t head = head_.load(std::memory_order_acquire);
+                while (tail != head)
+                {
+                    try
+                    {
+                        files_.write(*queue_[tail]);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        thread_supervisor_.log("Writing failed: ", e.what());
+                    }
+                    tail = next(tail);
+                    tail_.store(tail, std::memory_order_release);
+                }
+                files_.rotate();
+
+                if (stop)
+                {
+                    return;
+                }
+                lock.lock();
+            }
+        }
+
+    public:
+        Output(intrometry::backend::SinkCounters &counters, tut::thread::Supervisor<> &thread_supervisor)
+          : files_(thread_supervisor), counters_(counters), thread_supervisor_(thread_supervisor)
+        {
+            head_ = 0;
+            tail_ = 0;
+            stop_ = false;
+        }
+
+        ~Output()
+        {
+            stop();
+        }
+
+        Output(const Output &) = delete;
+        Output &operator=(const Output &) = delete;
+
+        /// @param[in] queue_size size of the I/O queue, 0 -- write in the calling thread
+        void initialize(const FileSequence::Parameters &parameters, const std::size_t queue_size)
+        {
+            files_.initialize(parameters);
+
+            if (queue_size > 0)
+            {
+                // one slot is always kept free
+                queue_.resize(queue_size + 1);
+                for (std::shared_ptr<pjmsg_mcap_wrapper::Message> &message : queue_)
+                {
+                    message = std::make_shared<pjmsg_mcap_wrapper::Message>();
+                }
+                thread_ = std::thread(&Output::spin, this, parameters.thread_parameters_);
+            }
+        }
+
+        /// Write all queued messages, stop the I/O thread, and close files
+        void stop()
+        {
+            if (thread_.joinable())
+            {
+                {
+                    const std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                condition_.notify_one();
+                thread_.join();
+            }
+            files_.stop();
+        }
+
+        /// @return false if the I/O queue is full
+        bool write(const pjmsg_mcap_wrapper::Message &message)
+        {
+            const std::lock_guard lock(push_mutex_);
+
+            if (queue_.empty())
+            {
+                files_.write(message);
+                return (true);
+            }
+
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (next(head) == tail_.load(std::memory_order_acquire))
+            {
+                intrometry::backend::increment(counters_.io_stalls_);
+                return (false);
+            }
+            // memory of preallocated messages is reused after the first pass
+            queue_[head]->reset(message);
+            head_.store(next(head), std::memory_order_release);
+            return (true);
+        }
+
+        /// Must be called after a batch of writes: wakes up the I/O thread or switches files
+        void notify()
+        {
+            if (queue_.empty())
+            {
+                const std::lock_guard lock(push_mutex_);
+                files_.rotate();
+            }
+            else
+            {
+                {
+                    // prevents lost wakeups
+                    const std::lock_guard lock(mutex_);
+                }
+                condition_.notify_one();
+            }
+        }
+    };
+
+
+    /**
+     * Flight recorder: bounded history of flushed messages of a source,
+     * messages are preallocated using the assigned structure of the source,
+     * the oldest messages are overwritten.
+     */
+    class History
+    {
+    protected:
+        std::vector<std::shared_ptr<pjmsg_mcap_wrapper::Message>> messages_;
+        // next slot to be overwritten
+        std::size_t head_;
+        std::size_t size_;
+        // snapshots may be written concurrently with flushing
+        std::mutex mutex_;
+
+    public:
+        /// @param[in] message template used to preallocate memory
+        History(const std::size_t size, const pjmsg_mcap_wrapper::Message &message)
+        {
+            messages_.resize(size);
+            for (std::shared_ptr<pjmsg_mcap_wrapper::Message> &slot : messages_)
+            {
+                slot = std::make_shared<pjmsg_mcap_wrapper::Message>();
+                slot->reset(message);
+            }
+            head_ = 0;
+            size_ = 0;
+        }
+
+        void push(const pjmsg_mcap_wrapper::Message &message)
+        {
+            const std::lock_guard lock(mutex_);
+            messages_[head_]->reset(message);
+            head_ = (head_ + 1) % messages_.size();
+            size_ = std::min(size_ + 1, messages_.size());
+        }
+
+        /// Write retained messages from the oldest to the newest
+        void write(pjmsg_mcap_wrapper::Writer &writer)
+        {
+            const std::lock_guard lock(mutex_);
+            for (std::size_t i = (head_ + messages_.size() - size_), end = i + size_; i < end; ++i)
+            {
+                writer.write(*messages_[i % messages_.size()]);
+            }
+        }
+    };
+
+
+    class WriterWrapper
+    {
+    public:
+        const std::string id_;  // NOLINT
+        ariles2::namevalue2::Writer::Parameters writer_parameters_;
+        std::shared_ptr<NameValueContainer> data_;
+        ariles2::namevalue2::Writer writer_;
+
+        std::mutex mutex_in_;
+        std::mutex mutex_out_;
+        std::atomic<bool> flushed_;
+
+        // lossless mode
+        std::unique_ptr<MessageRing> ring_;
+
+        // flight recorder mode: flushed messages are retained in memory
+        std::unique_ptr<History> history_;
+
+        // aggregation mode: min / max / mean series are published as a separate message
+        std::unique_ptr<intrometry::backend::Aggregator> aggregator_;
+        pjmsg_mcap_wrapper::Message aggregate_;
+        // version of names the aggregate names are generated from
+        uint32_t aggregate_source_version_;
+
+        // deferred mode: copies of the source, flattened by the consumer
+        std::shared_ptr<const intrometry::Source::Parameters::Copy> copy_;
+        std::unique_ptr<ariles2::DefaultBase> source_in_;
+        std::unique_ptr<ariles2::DefaultBase> source_out_;
+        uint64_t stamp_in_;
+        bool raw_in_;
+        std::atomic<uint32_t> &names_version_;
+        const intrometry::backend::Clock &clock_;
+
+        intrometry::backend::SourceCounters counters_;
+        // accessed by consumer only
+        uint32_t serialized_version_;
+        // version of the last written intrometry::Sample
+        uint64_t sample_version_;
+
+    public:
+        WriterWrapper(
+                const ariles2::DefaultBase &source,
+                std::string id,
+                const intrometry::Source::Parameters &parameters,
+                std::atomic<uint32_t> &names_version,
+                const std::size_t history_size,
+                const intrometry::backend::Clock &clock)
+          : id_(std::move(id))
+          , data_(std::make_shared<NameValueContainer>())
+          , writer_(data_)
+          , stamp_in_(0)
+          , raw_in_(false)
+          , names_version_(names_version)
+          , clock_(clock)
+          , sample_version_(0)
+        {
+            writer_parameters_ = writer_.getDefaultParameters();
+            if (parameters.persistent_structure_)
+            {
+                writer_parameters_.persistent_structure_ = true;
+            }
+
+            if (parameters.buffer_size_ > 0)
+            {
+                ring_ = std::make_unique<MessageRing>(parameters.buffer_size_);
+                data_->message_in_ = ring_->back().message_;
+            }
+            else if (parameters.copy_)
+            {
+                source_in_ = parameters.copy_->make(source);
+                if (source_in_)
+                {
+                    copy_ = parameters.copy_;
+                    source_out_ = copy_->make(source);
+                }
+            }
+
+            if (parameters.aggregate_ and not ring_ and not source_in_)
+            {
+                aggregator_ = std::make_unique<intrometry::backend::Aggregator>();
+            }
+
+            // write to allocate memory and generate names
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            data_->finalize(writer_parameters_.persistent_structure_, 0, names_version);
+
+            if (ring_)
+            {
+                ring_->reserve(*data_->message_in_);
+            }
+
+            if (history_size > 0)
+            {
+                history_ = std::make_unique<History>(history_size, *data_->message_in_);
+            }
+
+            flushed_ = true;  // do not serialize on assignment
+            serialized_version_ = data_->message_in_->getVersion() + 1;
+            aggregate_source_version_ = serialized_version_;
+        }
+
+        void snapshot(pjmsg_mcap_wrapper::Writer &writer)
+        {
+            if (history_)
+            {
+                history_->write(writer);
+            }
+        }
+
+        /// @return false if data is left for the next flush, e.g., the source is busy or the I/O queue is full
+        bool serialize(Output &output)
+        {
+            if (prepare())
+            {
+                commit(output);
+            }
+            return (ring_ ? ring_->empty() : flushed_.load());
+        }
+
+        /**
+         * Acquire unpublished data, on success must be followed by commit()
+         * in the same thread.
+         */
+        bool prepare()
+        {
+            if (ring_)
+            {
+                // there is a single consumer, but flushing may be triggered by the user
+                return (mutex_out_.try_lock());
+            }
+
+            if (not flushed_)
+            {
+                if (mutex_out_.try_lock())
+                {
+                    if (mutex_in_.try_lock())
+                    {
+                        if (source_in_)
+                        {
+                            std::swap(source_in_, source_out_);
+                            const uint64_t timestamp = raw_in_ ? clock_.toNanoseconds(stamp_in_) : stamp_in_;
+                            flushed_ = true;
+                            mutex_in_.unlock();
+
+                            // the consumer is the only user of data_ in deferred mode
+                            flatten(*source_out_, timestamp, names_version_);
+                            data_->swap();
+                            return (true);
+                        }
+
+                        data_->swap();
+                        if (aggregator_)
+                        {
+                            aggregator_->swap();
+                        }
+                        flushed_ = true;
+                        mutex_in_.unlock();
+                        return (true);
+                    }
+                    mutex_out_.unlock();
+                }
+                intrometry::backend::increment(counters_.flush_busy_);
+            }
+            return (false);
+        }
+
+        void commit(Output &output)
+        {
+            if (ring_)
+            {
+                // messages that do not fit in the I/O queue are retained in the ring
+                ring_->drain(
+                        [this, &output](MessageRing::Slot &slot)
+                        {
+                            if (slot.raw_)
+                            {
+                                slot.stamp_ = clock_.toNanoseconds(slot.stamp_);
+                                slot.message_->setStamp(slot.stamp_);
+                                slot.raw_ = false;
+                            }
+                            return (serialize(output, *slot.message_));
+                        });
+            }
+            else
+            {
+                uint64_t stamp = data_->stamp_out_;
+                if (data_->raw_out_)
+                {
+                    stamp = clock_.toNanoseconds(stamp);
+                    data_->message_out_->setStamp(stamp);
+                    data_->stamp_out_ = stamp;
+                    data_->raw_out_ = false;
+                }
+                if (serialize(output, *(data_->message_out_)) and aggregator_)
+                {
+                    aggregate(output, stamp);
+                }
+            }
+            mutex_out_.unlock();
+        }
+
+        /**
+         * @param[in] source ariles class or intrometry::Sample
+         * @param[in] timestamp nanoseconds since epoch, 0 -- use clock
+         * @return false if the source is deferred and cannot accept samples
+         * or sources of a different type
+         */
+        template <class t_Source>
+        bool write(const t_Source &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            if constexpr (std::is_same_v<t_Source, intrometry::Sample>)
+            {
+                if (copy_)
+                {
+                    return (false);
+                }
+            }
+
+            // conversion of raw clock readings is deferred to the consumer
+            const bool raw = (0 == timestamp and clock_.raw());
+            const uint64_t stamp = (0 == timestamp) ? clock_.ticks() : timestamp;
+
+            if (ring_)
+            {
+                // there is a single producer: concurrent writes are dropped
+                if (mutex_in_.try_lock())
+                {
+                    if (ring_->full())
+                    {
+                        intrometry::backend::increment(counters_.dropped_full_);
+                    }
+                    else
+                    {
+                        MessageRing::Slot &slot = ring_->back();
+                        data_->message_in_ = slot.message_;
+                        // messages in the ring are not swapped
+                        flatten(source, stamp, names_version);
+                        slot.stamp_ = stamp;
+                        slot.raw_ = raw;
+                        ring_->push();
+                        intrometry::backend::increment(counters_.accepted_);
+                    }
+                    mutex_in_.unlock();
+                }
+                else
+                {
+                    intrometry::backend::increment(counters_.dropped_busy_);
+                }
+                return (true);
+            }
 
-            // we cannot know for sure that the names have not changed
-            // without comparing all the names, do our best
-            if (not persistent_structure or previous_size_ != message_in_->size())
+            if (mutex_in_.try_lock())
             {
-                // fetch_add atomically returns the old value and increments,
-                // preventing concurrent writes from getting the same version.
-                message_in_->setVersion(names_version.fetch_add(1));
+                if (source_in_)
+                {
+                    // samples are rejected above
+                    if constexpr (not std::is_same_v<t_Source, intrometry::Sample>)
+                    {
+                        if (not copy_->assign(*source_in_, source))
+                        {
+                            // handles may be used with sources of other types
+                            mutex_in_.unlock();
+                            return (false);
+                        }
+                        stamp_in_ = stamp;
+                        raw_in_ = raw;
+                    }
+                }
+                else
+                {
+                    flatten(source, stamp, names_version);
+                    data_->raw_in_ = raw;
+                    if (aggregator_)
+                    {
+                        aggregator_->fold(data_->message_in_->values());
+                    }
+                }
+                if (not flushed_.exchange(false))
+                {
+                    intrometry::backend::increment(counters_.overwritten_);
+                }
+                intrometry::backend::increment(counters_.accepted_);
+                mutex_in_.unlock();
             }
-
-            previous_size_ = message_in_->size();
-        }
-
-        std::string &name(const std::size_t index)
-        {
-            return (message_in_->name(index));
+            else
+            {
+                intrometry::backend::increment(counters_.dropped_busy_);
+            }
+            return (true);
         }
 
-        double &value(const std::size_t index)
+        void getStatistics(intrometry::SourceStatistics &statistics) const
         {
-            return (message_in_->value(index));
+            counters_.get(statistics);
+            statistics.id_ = id_;
         }
 
-        void reserve(const std::size_t size)
+    protected:
+        void flatten(const ariles2::DefaultBase &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
         {
-            message_in_->reserve(size);
+            // names of persistent sources are generated only in the first pass
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            if (data_->finalize(writer_parameters_.persistent_structure_, timestamp, names_version)
+                and writer_parameters_.persistent_structure_)
+            {
+                // structure has changed, traverse again to generate names
+                ariles2::apply(writer_, source, id_);
+            }
         }
 
-        void resize(const std::size_t size)
+        void flatten(const intrometry::Sample &sample, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
         {
-            message_in_->resize(size);
+            const bool names_changed = intrometry::backend::copySample(*data_, sample, sample_version_);
+            data_->finalize(writer_parameters_.persistent_structure_ and not names_changed, timestamp, names_version);
         }
 
-        [[nodiscard]] std::size_t size() const
+        bool emit(Output &output, const pjmsg_mcap_wrapper::Message &message)
         {
-            return (message_in_->size());
+            if (history_)
+            {
+                history_->push(message);
+                return (true);
+            }
+            return (output.write(message));
         }
-    };
-}  // namespace
-
-
-namespace
-{
-    class WriterWrapper
-    {
-    public:
-        const std::string id_;  // NOLINT
-        ariles2::namevalue2::Writer::Parameters writer_parameters_;
-        std::shared_ptr<NameValueContainer> data_;
-        ariles2::namevalue2::Writer writer_;
-
-        std::mutex mutex_in_;
-        std::mutex mutex_out_;
-        std::atomic<bool> flushed_;
 
-    public:
-        WriterWrapper(
-                const ariles2::DefaultBase &source,
-                std::string id,
-                const bool persistent_structure,
-                std::atomic<uint32_t> &names_version)
-          : id_(std::move(id)), data_(std::make_shared<NameValueContainer>()), writer_(data_)
+        bool serialize(Output &output, const pjmsg_mcap_wrapper::Message &message)
         {
-            writer_parameters_ = writer_.getDefaultParameters();
-            if (persistent_structure)
+            if (not emit(output, message))
             {
-                writer_parameters_.persistent_structure_ = true;
+                return (false);
             }
 
-            // write to allocate memory
-            ariles2::apply(writer_, source, id_);
-            data_->finalize(writer_parameters_.persistent_structure_, 0, names_version);
-
-            flushed_ = true;  // do not serialize on assignment
+            std::size_t bytes = message.size() * sizeof(double);
+            if (serialized_version_ != message.getVersion())
+            {
+                // names are written only when changed
+                serialized_version_ = message.getVersion();
+                for (const std::string &name : message.names())
+                {
+                    bytes += name.size();
+                }
+            }
+            intrometry::backend::increment(counters_.flushed_);
+            intrometry::backend::increment(counters_.bytes_, bytes);
+            return (true);
         }
 
-        void serialize(pjmsg_mcap_wrapper::Writer &mcap_writer)
+        void aggregate(Output &output, const uint64_t stamp)
         {
-            if (not flushed_)
+            const intrometry::backend::Aggregator::Window &window = aggregator_->window();
+            const pjmsg_mcap_wrapper::Message &message = *(data_->message_out_);
+            if (0 == window.count_ or window.sum_.size() != message.size())
+            {
+                return;
+            }
+
+            if (aggregate_source_version_ != message.getVersion())
             {
-                if (mutex_in_.try_lock() && mutex_out_.try_lock())
+                // aggregate names have their own version
+                aggregate_source_version_ = message.getVersion();
+                aggregate_.resize(message.size() * intrometry::backend::Aggregator::SUFFIXES.size());
+                std::size_t index = 0;
+                for (const char *suffix : intrometry::backend::Aggregator::SUFFIXES)
                 {
-                    data_->swap();
-                    mutex_in_.unlock();
-                    mcap_writer.write(*(data_->message_out_));
-                    flushed_ = true;
-                    mutex_out_.unlock();
+                    for (const std::string &name : message.names())
+                    {
+                        aggregate_.name(index++) = intrometry::backend::str_concat(name, suffix);
+                    }
                 }
+                aggregate_.setVersion(names_version_.fetch_add(1));
             }
-        }
 
-        void write(const ariles2::DefaultBase &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
-        {
-            if (mutex_in_.try_lock())
+            aggregator_->get([this](const std::size_t index) -> double & { return (aggregate_.value(index)); });
+            aggregate_.setStamp(stamp);
+            if (emit(output, aggregate_))
             {
-                ariles2::apply(writer_, source, id_);
-                data_->finalize(writer_parameters_.persistent_structure_, timestamp, names_version);
-                flushed_ = false;
-                mutex_in_.unlock();
+                intrometry::backend::increment(counters_.bytes_, aggregate_.size() * sizeof(double));
             }
         }
     };
@@ -170,6 +1294,15 @@ namespace intrometry::pjmsg_mcap::sink
         rate_ = 500;
         id_ = id;
         compression_ = Compression::NONE;
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+        io_queue_size_ = 0;
+        max_file_size_ = 0;
+        max_file_duration_ = std::chrono::seconds(0);
+        max_files_ = 0;
+        history_duration_ = std::chrono::seconds(0);
     }
 
     Parameters::Parameters(const char *id)
@@ -177,6 +1310,15 @@ namespace intrometry::pjmsg_mcap::sink
         rate_ = 500;
         id_ = id;
         compression_ = Compression::NONE;
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+        io_queue_size_ = 0;
+        max_file_size_ = 0;
+        max_file_duration_ = std::chrono::seconds(0);
+        max_files_ = 0;
+        history_duration_ = std::chrono::seconds(0);
     }
 
     Parameters &Parameters::rate(const std::size_t value)
@@ -202,6 +1344,66 @@ namespace intrometry::pjmsg_mcap::sink
         compression_ = value;
         return (*this);
     }
+
+    Parameters &Parameters::statistics(const bool value)
+    {
+        statistics_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::clock(const Clock &value)
+    {
+        clock_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::thread(const ThreadParameters &value)
+    {
+        thread_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::shared_threads(const std::size_t value)
+    {
+        shared_threads_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::io_queue_size(const std::size_t value)
+    {
+        io_queue_size_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::max_file_size(const uint64_t value)
+    {
+        max_file_size_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::max_file_duration(const std::chrono::seconds value)
+    {
+        max_file_duration_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::max_files(const std::size_t value)
+    {
+        max_files_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::history_duration(const std::chrono::seconds value)
+    {
+        history_duration_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::snapshot_signals(const std::vector<int> &value)
+    {
+        snapshot_signals_ = value;
+        return (*this);
+    }
 }  // namespace intrometry::pjmsg_mcap::sink
 
 
@@ -210,74 +1412,202 @@ namespace intrometry::pjmsg_mcap::sink
     class Implementation
     {
     protected:
-        pjmsg_mcap_wrapper::Writer mcap_writer_;
+        intrometry::SinkStatistics statistics_;
+        SourceHandle statistics_handle_;
+
+        // flight recorder mode
+        FileSequence::Parameters file_parameters_;
+        std::atomic<uint64_t> snapshot_requests_;
+        // accessed by the spinning thread only
+        uint64_t snapshot_served_;
+        uint64_t snapshot_signals_served_;
+        std::size_t snapshot_index_;
 
     public:
         std::atomic<uint32_t> names_version_;
+        // number of messages retained per source, 0 -- history is disabled
+        std::size_t history_size_;
+        intrometry::backend::Clock clock_;
+        intrometry::backend::RateTimer timer_;
+        // shared flush thread mode
+        std::shared_ptr<intrometry::backend::FlushService> flush_service_;
+        std::unique_ptr<intrometry::backend::FlushService::Task> flush_task_;
+        // accessed by the flushing thread only
+        std::chrono::steady_clock::time_point second_deadline_;
 
         intrometry::backend::SourceContainer<WriterWrapper> sources_;
+        intrometry::backend::SinkCounters counters_;
         tut::thread::Supervisor<> thread_supervisor_;
 
+    protected:
+        Output output_;
+
     public:
-        Implementation(
-                const std::filesystem::path &directory,
-                const std::string &sink_id,
-                const std::size_t rate,
-                const Parameters::Compression compression)
+        explicit Implementation(const Parameters &parameters)
+          : clock_(parameters.clock_)
+          , timer_(parameters.rate_, getMaxIdleSteps(parameters, clock_))
+          , output_(counters_, thread_supervisor_)
         {
             names_version_ = intrometry::backend::getRandomUInt32();
-
-            const std::string node_id = intrometry::backend::normalizeId(sink_id);
+            history_size_ = static_cast<std::size_t>(parameters.history_duration_.count()) * parameters.rate_;
+            snapshot_requests_ = 0;
+            snapshot_served_ = 0;
+            snapshot_signals_served_ = snapshot_signals.requested_.load();
+            snapshot_index_ = 0;
+            second_deadline_ = std::chrono::steady_clock::now();
+
+            const std::string node_id = intrometry::backend::normalizeId(parameters.id_);
             const std::string random_id = intrometry::backend::getRandomId(8);
             const std::string topic_prefix =
                     intrometry::backend::str_concat("/intrometry/", node_id.empty() ? random_id : node_id);
 
-            if (not directory.empty())
+            if (not parameters.directory_.empty())
+            {
+                std::filesystem::create_directories(parameters.directory_);
+            }
+            FileSequence::Parameters file_parameters;
+            file_parameters.max_file_size_ = parameters.max_file_size_;
+            file_parameters.max_file_duration_ = parameters.max_file_duration_;
+            file_parameters.max_files_ = parameters.max_files_;
+            file_parameters.thread_parameters_ = parameters.thread_;
+            file_parameters.topic_prefix_ = topic_prefix;
+            file_parameters.writer_parameters_ = getWriterParameters(parameters);
+            // files are numbered only when rotation or history are enabled
+            const bool numbered = (parameters.max_file_size_ > 0 or parameters.max_file_duration_.count() > 0
+                                   or history_size_ > 0);
+            file_parameters.filename_ = [directory = parameters.directory_, node_id, random_id, numbered](
+                                                const std::size_t index)
+            {
+                std::stringstream suffix;
+                if (numbered)
+                {
+                    suffix << "_" << std::setw(4) << std::setfill('0') << index;  // NOLINT
+                }
+                return (directory
+                        / intrometry::backend::str_concat(
+                                node_id,
+                                node_id.empty() ? "" : "_",
+                                getDateString(),
+                                "_",
+                                random_id,
+                                suffix.str(),
+                                ".mcap"));
+            };
+
+            if (history_size_ > 0)
+            {
+                // files are written only on snapshots
+                file_parameters_ = file_parameters;
+                snapshot_signals.acquire(
+                        parameters.snapshot_signals_,
+                        [this](const int signal)
+                        { thread_supervisor_.log("Could not install snapshot signal handler: ", signal); });
+            }
+            else
+            {
+                output_.initialize(file_parameters, parameters.io_queue_size_);
+            }
+
+            if (parameters.statistics_)
+            {
+                statistics_handle_ = SourceHandle(
+                        this,
+                        sources_.tryEmplace(
+                                "",
+                                statistics_,
+                                Source::Parameters(/*persistent_structure=*/true),
+                                names_version_,
+                                history_size_,
+                                clock_));
+            }
+
+            if (parameters.shared_threads_ > 0)
+            {
+                share(parameters);
+            }
+            else
+            {
+                thread_supervisor_.add(
+                        tut::thread::Parameters(
+                                tut::thread::Parameters::Restart(/*attempts=*/100, /*sleep_ms=*/50),
+                                tut::thread::Parameters::TerminationPolicy::IGNORE,
+                                tut::thread::Parameters::ExceptionPolicy::CATCH),
+                        &Implementation::spin,
+                        this,
+                        parameters.thread_,
+                        parameters.statistics_);
+            }
+        }
+
+        static std::size_t getMaxIdleSteps(const Parameters &parameters, const intrometry::backend::Clock &clock)
+        {
+            if (parameters.history_duration_.count() > 0)
+            {
+                // snapshot signals are polled
+                return (1);
+            }
+            if (parameters.statistics_ or clock.raw())
             {
-                std::filesystem::create_directories(directory);
+                // statistics publishing and clock anchoring
+                return (parameters.rate_);
             }
-            const std::filesystem::path filename =
-                    directory
-                    / intrometry::backend::str_concat(
-                            node_id, node_id.empty() ? "" : "_", getDateString(), "_", random_id, ".mcap");
+            return (0);
+        }
+
+        static pjmsg_mcap_wrapper::Writer::Parameters getWriterParameters(const Parameters &parameters)
+        {
+            using WriterParameters = pjmsg_mcap_wrapper::Writer::Parameters;
 
-            // Create writer parameters with the specified compression
-            pjmsg_mcap_wrapper::Writer::Parameters writer_params;
-            if (Parameters::Compression::ZSTD == compression)
+            WriterParameters result;
+            switch (parameters.compression_)
             {
-                writer_params.compression_ = pjmsg_mcap_wrapper::Writer::Parameters::Compression::ZSTD;
+                case Parameters::Compression::NONE:
+                    result.compression_ = WriterParameters::Compression::NONE;
+                    break;
+                case Parameters::Compression::ZSTD:
+                    result.compression_ = WriterParameters::Compression::ZSTD;
+                    break;
             }
-            mcap_writer_.initialize(filename, topic_prefix, writer_params);
 
-            thread_supervisor_.add(
-                    tut::thread::Parameters(
-                            tut::thread::Parameters::Restart(/*attempts=*/100, /*sleep_ms=*/50),
-                            tut::thread::Parameters::TerminationPolicy::IGNORE,
-                            tut::thread::Parameters::ExceptionPolicy::CATCH),
-                    &Implementation::spin,
-                    this,
-                    rate);
+            return (result);
         }
 
         virtual ~Implementation()
         {
+            if (flush_task_)
+            {
+                flush_service_->remove(*flush_task_);
+                flush();
+            }
+            thread_supervisor_.interrupt();
+            timer_.interrupt();
             thread_supervisor_.stop();
+            // the I/O thread is used by the final flush of the spinning thread
+            output_.stop();
+            if (history_size_ > 0)
+            {
+                snapshot_signals.release();
+            }
         }
 
 
-        void spin(const std::size_t rate)
+        void spin(const ThreadParameters &thread_parameters, const bool publish_statistics)
         {
-            intrometry::backend::RateTimer timer(rate);
-
-            if (timer.valid())
+            const std::string thread_errors = intrometry::backend::configureThread(thread_parameters);
+            if (not thread_errors.empty())
             {
-                timer.start();
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            counters_.sampleThread();
 
+            if (timer_.valid())
+            {
+                timer_.start();
                 while (not thread_supervisor_.isInterrupted())
                 {
-                    flush();
-
-                    timer.step();
+                    step(publish_statistics);
+                    intrometry::backend::increment(counters_.flush_overruns_, timer_.step());
                 }
                 flush();
             }
@@ -289,9 +1619,178 @@ namespace intrometry::pjmsg_mcap::sink
         }
 
 
+        /// Execute periodic tasks using the process-wide flush service instead of a dedicated thread
+        void share(const Parameters &parameters)
+        {
+            flush_task_ = std::make_unique<intrometry::backend::FlushService::Task>(
+                    parameters.rate_,
+                    getMaxIdleSteps(parameters, clock_),
+                    [this, publish_statistics = parameters.statistics_](const std::size_t skipped_steps)
+                    {
+                        step(publish_statistics);
+                        intrometry::backend::increment(counters_.flush_overruns_, skipped_steps);
+                    });
+            if (not flush_task_->valid())
+            {
+                flush_task_.reset();
+                thread_supervisor_.log("Incorrect spin rate");
+                return;
+            }
+
+            flush_service_ = intrometry::backend::FlushService::get(parameters.shared_threads_, parameters.thread_);
+            const std::string thread_errors = flush_service_->getThreadErrors();
+            if (not thread_errors.empty())
+            {
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            flush_service_->add(*flush_task_);
+        }
+
+
+        void step(const bool publish_statistics)
+        {
+            flush();
+            if (history_size_ > 0)
+            {
+                serveSnapshots();
+            }
+
+            // statistics are published and the clock is re-anchored once per second
+            if (std::chrono::steady_clock::now() >= second_deadline_)
+            {
+                second_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                clock_.anchor();
+                counters_.sampleThread();
+                if (publish_statistics)
+                {
+                    getStatistics(statistics_);
+                    write(statistics_handle_, statistics_, 0);
+                }
+            }
+        }
+
+
+        void notify()
+        {
+            if (flush_task_)
+            {
+                flush_task_->notify();
+            }
+            else
+            {
+                timer_.notify();
+            }
+        }
+
+
+        void snapshot()
+        {
+            snapshot_requests_.fetch_add(1);
+            notify();
+        }
+
+
+        /// Write history of all sources to a new file if requested by the user or a signal
+        void serveSnapshots()
+        {
+            const uint64_t requests = snapshot_requests_.load();
+            const uint64_t signals = snapshot_signals.requested_.load();
+            if (requests == snapshot_served_ and signals == snapshot_signals_served_)
+            {
+                return;
+            }
+
+            try
+            {
+                pjmsg_mcap_wrapper::Writer writer;
+                writer.initialize(
+                        file_parameters_.filename_(snapshot_index_++),
+                        file_parameters_.topic_prefix_,
+                        file_parameters_.writer_parameters_);
+                sources_.visit([&writer](WriterWrapper &source) { source.snapshot(writer); });
+            }
+            catch (const std::exception &e)
+            {
+                thread_supervisor_.log("Writing snapshot failed: ", e.what());
+            }
+
+            snapshot_served_ = requests;
+            snapshot_signals_served_ = signals;
+            snapshot_signals.complete(signals);
+        }
+
+
         void flush()
         {
-            sources_.tryFlush([this](WriterWrapper &writer) { writer.serialize(mcap_writer_); });
+            intrometry::backend::increment(counters_.flush_ticks_);
+            bool pending = false;
+            sources_.visit(
+                    [this, &pending](WriterWrapper &writer)
+                    {
+                        if (not writer.serialize(output_))
+                        {
+                            pending = true;
+                        }
+                    });
+            output_.notify();
+            if (pending)
+            {
+                // keep flushing, the sink thread would go idle otherwise
+                notify();
+            }
+        }
+
+
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+        {
+            switch (sources_.write(
+                    id,
+                    source,
+                    [this, &source, &timestamp](WriterWrapper &writer)
+                    {
+                        writer.write(source, timestamp, names_version_);
+                    }))
+            {
+                case intrometry::backend::SourceContainerBase::WriteStatus::ACCEPTED:
+                    notify();
+                    break;
+
+                case intrometry::backend::SourceContainerBase::WriteStatus::UNASSIGNED:
+                    intrometry::backend::increment(counters_.unassigned_);
+                    thread_supervisor_.log(
+                            "Measurement source handler is not assigned, skipping id: ", source.arilesDefaultID());
+                    break;
+            }
+        }
+
+
+        template <class t_Source>
+        void write(const SourceHandle &handle, const t_Source &source, const uint64_t timestamp)
+        {
+            const std::shared_ptr<WriterWrapper> writer = handle.lock<WriterWrapper>(this);
+            if (writer and writer->write(source, timestamp, names_version_))
+            {
+                notify();
+            }
+            else
+            {
+                // samples and sources of other types cannot be written to deferred sources
+                intrometry::backend::increment(counters_.unassigned_);
+            }
+        }
+
+
+        void getStatistics(SinkStatistics &statistics)
+        {
+            statistics.sources_.clear();
+            sources_.visit(
+                    [&statistics](const WriterWrapper &writer)
+                    {
+                        statistics.sources_.emplace_back();
+                        writer.getStatistics(statistics.sources_.back());
+                    });
+            counters_.get(statistics);
         }
     };
 }  // namespace intrometry::pjmsg_mcap::sink
@@ -308,17 +1807,24 @@ namespace intrometry::pjmsg_mcap
         {
             return (false);
         }
-        make_pimpl(parameters_.directory_, parameters_.id_, parameters_.rate_, parameters_.compression_);
+        make_pimpl(parameters_);
         return (true);
     }
 
 
-    void Sink::assign(const std::string &id, const ariles2::DefaultBase &source, const Source::Parameters &parameters)
+    SourceHandle Sink::assign(
+            const std::string &id,
+            const ariles2::DefaultBase &source,
+            const Source::Parameters &parameters)
     {
         if (pimpl_)
         {
-            pimpl_->sources_.tryEmplace(id, source, parameters.persistent_structure_, pimpl_->names_version_);
+            return (SourceHandle(
+                    pimpl_.get(),
+                    pimpl_->sources_.tryEmplace(
+                            id, source, parameters, pimpl_->names_version_, pimpl_->history_size_, pimpl_->clock_)));
         }
+        return (SourceHandle());
     }
 
 
@@ -335,20 +1841,25 @@ namespace intrometry::pjmsg_mcap
     {
         if (pimpl_)
         {
-            if (not pimpl_->sources_.tryWrite(
-                        id,
-                        source,
-                        [this, &source, &timestamp](WriterWrapper &writer)
-                        {
-                            writer.write(
-                                    source,
-                                    (0 == timestamp) ? intrometry::backend::now() : timestamp,
-                                    pimpl_->names_version_);
-                        }))
-            {
-                pimpl_->thread_supervisor_.log(
-                        "Measurement source handler is not assigned, skipping id: ", source.arilesDefaultID());
-            }
+            pimpl_->write(id, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, sample, timestamp);
         }
     }
 
@@ -360,4 +1871,26 @@ namespace intrometry::pjmsg_mcap
             pimpl_->flush();
         }
     }
+
+
+    bool Sink::snapshot()
+    {
+        if (pimpl_ and pimpl_->history_size_ > 0)
+        {
+            pimpl_->snapshot();
+            return (true);
+        }
+        return (false);
+    }
+
+
+    SinkStatistics Sink::statistics() const
+    {
+        SinkStatistics result;
+        if (pimpl_)
+        {
+            pimpl_->getStatistics(result);
+        }
+        return (result);
+    }
 }  // namespace intrometry::pjmsg_mcap
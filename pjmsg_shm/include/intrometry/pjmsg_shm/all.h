@@ -0,0 +1,12 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+*/
+
+#pragma once
+
+#include <intrometry/intrometry.h>
+#include <intrometry/pjmsg_shm/sink.h>
+#include <intrometry/pjmsg_shm/reader.h>
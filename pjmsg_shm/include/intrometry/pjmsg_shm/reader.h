@@ -0,0 +1,70 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Reader of the shared memory ring.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <intrometry/backend/utils.h>
+
+
+namespace intrometry::pjmsg_shm
+{
+    /**
+     * @brief Reads samples written by a shared memory sink, typically in a
+     * separate process. There must be only one reader per sink.
+     */
+    class INTROMETRY_PUBLIC Reader
+    {
+    public:
+        class Sample
+        {
+        public:
+            /// source number, unique within a sink
+            uint32_t source_;
+            /// nanoseconds
+            uint64_t stamp_;
+            /// names version, changes with names
+            uint32_t version_;
+            /**
+             * names are present only in the first sample of each version,
+             * and are empty otherwise
+             */
+            std::vector<std::string> names_;
+            std::vector<double> values_;
+        };
+
+    protected:
+        class Implementation;
+
+    protected:
+        std::unique_ptr<Implementation> pimpl_;
+
+    public:
+        Reader();
+        ~Reader();
+
+        /// Attach to the ring of the sink with the given id, sink must be initialized
+        bool initialize(const std::string &id);
+
+        /**
+         * Read the next sample.
+         * @return false if there are no new samples
+         */
+        bool next(Sample &sample);
+
+        /// @return false if the sink is destroyed or its process has terminated
+        [[nodiscard]] bool alive() const;
+
+        /// @return number of samples dropped by the sink due to full ring
+        [[nodiscard]] uint64_t dropped() const;
+    };
+}  // namespace intrometry::pjmsg_shm
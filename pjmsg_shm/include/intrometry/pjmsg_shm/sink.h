@@ -0,0 +1,96 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Sink class.
+*/
+
+#pragma once
+
+#include <intrometry/sink.h>
+#include <intrometry/backend/utils.h>
+
+
+namespace intrometry::pjmsg_shm
+{
+    namespace sink
+    {
+        class INTROMETRY_PUBLIC Parameters
+        {
+        public:
+            /**
+             * publish rate (system clock),
+             * data written at higher rate is going to overwrite unpublished data
+             */
+            std::size_t rate_;
+            /// id of the sink, disables publishing if empty
+            std::string id_;
+
+            /// size of the shared memory ring in bytes
+            std::size_t size_;
+
+            /// publish sink statistics as an extra source once per second
+            bool statistics_;
+
+            /// clock used to timestamp data written without explicit timestamps
+            Clock clock_;
+
+            /// placement of the sink thread
+            ThreadParameters thread_;
+
+            /**
+             * size of the process-wide pool of threads shared by all sinks of
+             * this backend that enable it, sinks are flushed at their own
+             * rates; the pool is created by the first sink with its `thread`
+             * parameters and stopped with the last one. 0 -- dedicated
+             * thread.
+             */
+            std::size_t shared_threads_;
+
+        public:
+            // cppcheck-suppress noExplicitConstructor
+            Parameters(const std::string &id = "");  // NOLINT
+            // cppcheck-suppress noExplicitConstructor
+            Parameters(const char *id = "");  // NOLINT
+
+            Parameters &rate(const std::size_t value);
+            Parameters &id(const std::string &value);
+            Parameters &size(const std::size_t value);
+            Parameters &statistics(const bool value);
+            Parameters &clock(const Clock &value);
+            Parameters &thread(const ThreadParameters &value);
+            Parameters &shared_threads(const std::size_t value);
+        };
+
+        class Implementation;
+    }  // namespace sink
+
+
+    /**
+     * @brief Publish data to a shared memory ring, which is read by a
+     * separate recorder process.
+     */
+    class INTROMETRY_PUBLIC Sink : public SinkPIMPLBase<sink::Parameters, sink::Implementation>
+    {
+    public:
+        using SinkPIMPLBase::assign;
+        using SinkPIMPLBase::retract;
+        using SinkPIMPLBase::SinkPIMPLBase;
+        using SinkPIMPLBase::write;
+        ~Sink();
+
+        bool initialize();
+        SourceHandle assign(
+                const std::string &id,
+                const ariles2::DefaultBase &source,
+                const Source::Parameters &parameters = Source::Parameters());
+        void retract(const std::string &id, const ariles2::DefaultBase &source);
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp = 0);
+        void flush();
+        [[nodiscard]] SinkStatistics statistics() const;
+    };
+}  // namespace intrometry::pjmsg_shm
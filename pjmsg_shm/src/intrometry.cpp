@@ -0,0 +1,703 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <atomic>
+#include <chrono>
+
+#include <ariles2/visitors/namevalue2.h>
+#include <thread_supervisor/supervisor.h>
+
+#include "intrometry/intrometry.h"
+#include "intrometry/backend/utils.h"
+#include "intrometry/pjmsg_shm/sink.h"
+
+#include "ring.h"
+
+
+namespace
+{
+    class Message
+    {
+    public:
+        uint64_t stamp_ = 0;
+        /// stamp is a raw clock reading to be converted by the consumer
+        bool raw_ = false;
+        uint32_t version_ = 0;
+        std::vector<std::string> names_;
+        std::vector<double> values_;
+    };
+
+
+    class NameValueContainer : public ariles2::namevalue2::NameValueContainer
+    {
+    public:
+        std::shared_ptr<Message> message_in_;
+        std::shared_ptr<Message> message_out_;
+        intrometry::backend::StructureTracker structure_;
+
+    public:
+        NameValueContainer()
+        {
+            message_out_ = std::make_shared<Message>();
+            message_in_ = std::make_shared<Message>();
+        }
+
+        void swap()
+        {
+            if (message_out_->version_ != message_in_->version_)
+            {
+                message_out_->names_ = message_in_->names_;
+                message_out_->values_.resize(message_in_->values_.size());
+                message_out_->version_ = message_in_->version_;
+            }
+            std::swap(message_out_, message_in_);
+        }
+
+        /// @return true if names have changed
+        bool finalize(const bool persistent_structure, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            message_in_->stamp_ = timestamp;
+            message_in_->raw_ = false;
+
+            const bool names_changed = structure_.update(message_in_->names_, persistent_structure);
+            if (names_changed)
+            {
+                message_in_->version_ = names_version.fetch_add(1);
+            }
+
+            return (names_changed);
+        }
+
+        std::string &name(const std::size_t index)
+        {
+            return (message_in_->names_[index]);
+        }
+        double &value(const std::size_t index)
+        {
+            return (message_in_->values_[index]);
+        }
+
+        void reserve(const std::size_t size)
+        {
+            message_in_->names_.reserve(size);
+            message_in_->values_.reserve(size);
+        }
+        [[nodiscard]] std::size_t size() const
+        {
+            return (message_in_->names_.size());
+        }
+        void resize(const std::size_t size)
+        {
+            message_in_->names_.resize(size);
+            message_in_->values_.resize(size);
+        }
+    };
+}  // namespace
+
+
+namespace
+{
+    class WriterWrapper
+    {
+    public:
+        const std::string id_;  // NOLINT
+        ariles2::namevalue2::Writer::Parameters writer_parameters_;
+        std::shared_ptr<NameValueContainer> data_;
+        ariles2::namevalue2::Writer writer_;
+
+        std::mutex mutex_in_;
+        std::mutex mutex_out_;
+        std::atomic<bool> flushed_;
+
+        intrometry::backend::SourceCounters counters_;
+
+        const intrometry::backend::Clock &clock_;
+        // version of the last written intrometry::Sample
+        uint64_t sample_version_;
+
+        // accessed by the flushing thread only
+        const uint32_t source_;  // NOLINT
+        uint32_t published_version_;
+        uint32_t published_generation_;
+
+    public:
+        WriterWrapper(
+                const ariles2::DefaultBase &source,
+                std::string id,
+                const intrometry::Source::Parameters &parameters,
+                std::atomic<uint32_t> &names_version,
+                const intrometry::backend::Clock &clock,
+                const uint32_t source_number)
+          : id_(std::move(id))
+          , data_(std::make_shared<NameValueContainer>())
+          , writer_(data_)
+          , clock_(clock)
+          , sample_version_(0)
+          , source_(source_number)
+        {
+            writer_parameters_ = writer_.getDefaultParameters();
+            if (parameters.persistent_structure_)
+            {
+                writer_parameters_.persistent_structure_ = true;
+            }
+
+            // write to allocate memory and generate names
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            data_->finalize(writer_parameters_.persistent_structure_, 0, names_version);
+
+            flushed_ = true;  // do not publish on assignment
+            published_version_ = data_->message_in_->version_ + 1;
+            published_generation_ = 0;
+        }
+
+
+        /// @return false if data is left for the next flush, i.e., the source is busy
+        bool publish(intrometry::pjmsg_shm::ring::Producer &producer, intrometry::backend::SinkCounters &sink_counters)
+        {
+            if (not flushed_)
+            {
+                if (mutex_out_.try_lock())
+                {
+                    if (mutex_in_.try_lock())
+                    {
+                        data_->swap();
+                        flushed_ = true;
+                        mutex_in_.unlock();
+
+                        Message &message = *data_->message_out_;
+                        if (message.raw_)
+                        {
+                            message.stamp_ = clock_.toNanoseconds(message.stamp_);
+                            message.raw_ = false;
+                        }
+
+                        // names are republished until accepted and for new consumers
+                        const uint32_t generation = producer.getConsumerGeneration();
+                        const bool publish_names =
+                                (published_version_ != message.version_ or published_generation_ != generation);
+
+                        if (producer.write(
+                                    message.stamp_,
+                                    source_,
+                                    message.version_,
+                                    publish_names ? &message.names_ : nullptr,
+                                    message.values_))
+                        {
+                            std::size_t bytes = message.values_.size() * sizeof(double);
+                            if (publish_names)
+                            {
+                                published_version_ = message.version_;
+                                published_generation_ = generation;
+                                for (const std::string &name : message.names_)
+                                {
+                                    bytes += name.size();
+                                }
+                            }
+                            intrometry::backend::increment(counters_.flushed_);
+                            intrometry::backend::increment(counters_.bytes_, bytes);
+                            mutex_out_.unlock();
+                            return (true);
+                        }
+                        // the ring is full, the sample is lost and names are resent with the next one
+                        intrometry::backend::increment(sink_counters.io_stalls_);
+                        mutex_out_.unlock();
+                        return (true);
+                    }
+                    mutex_out_.unlock();
+                }
+                intrometry::backend::increment(counters_.flush_busy_);
+                return (false);
+            }
+            return (true);
+        }
+
+
+        /// @param[in] timestamp nanoseconds since epoch, 0 -- use clock
+        /// @param[in] source ariles class or intrometry::Sample
+        template <class t_Source>
+        void write(const t_Source &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            // conversion of raw clock readings is deferred to the consumer
+            const bool raw = (0 == timestamp and clock_.raw());
+            const uint64_t stamp = (0 == timestamp) ? clock_.ticks() : timestamp;
+
+            if (mutex_in_.try_lock())
+            {
+                flatten(source, stamp, names_version);
+                data_->message_in_->raw_ = raw;
+                if (not flushed_.exchange(false))
+                {
+                    intrometry::backend::increment(counters_.overwritten_);
+                }
+                intrometry::backend::increment(counters_.accepted_);
+                mutex_in_.unlock();
+            }
+            else
+            {
+                intrometry::backend::increment(counters_.dropped_busy_);
+            }
+        }
+
+
+        void getStatistics(intrometry::SourceStatistics &statistics) const
+        {
+            counters_.get(statistics);
+            statistics.id_ = id_;
+        }
+
+    protected:
+        void flatten(const ariles2::DefaultBase &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            // names of persistent sources are generated only in the first pass
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            if (data_->finalize(writer_parameters_.persistent_structure_, timestamp, names_version)
+                and writer_parameters_.persistent_structure_)
+            {
+                // structure has changed, traverse again to generate names
+                ariles2::apply(writer_, source, id_);
+            }
+        }
+
+        void flatten(const intrometry::Sample &sample, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            const bool names_changed = intrometry::backend::copySample(*data_, sample, sample_version_);
+            data_->finalize(writer_parameters_.persistent_structure_ and not names_changed, timestamp, names_version);
+        }
+    };
+}  // namespace
+
+
+namespace intrometry::pjmsg_shm::sink
+{
+    Parameters::Parameters(const std::string &id)
+    {
+        rate_ = 500;
+        id_ = id;
+        size_ = 16 * 1024 * 1024;  // NOLINT
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+    }
+
+    Parameters::Parameters(const char *id)
+    {
+        rate_ = 500;
+        id_ = id;
+        size_ = 16 * 1024 * 1024;  // NOLINT
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+    }
+
+    Parameters &Parameters::rate(const std::size_t value)
+    {
+        rate_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::id(const std::string &value)
+    {
+        id_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::size(const std::size_t value)
+    {
+        size_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::statistics(const bool value)
+    {
+        statistics_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::clock(const Clock &value)
+    {
+        clock_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::thread(const ThreadParameters &value)
+    {
+        thread_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::shared_threads(const std::size_t value)
+    {
+        shared_threads_ = value;
+        return (*this);
+    }
+}  // namespace intrometry::pjmsg_shm::sink
+
+
+namespace intrometry::pjmsg_shm::sink
+{
+    class Implementation
+    {
+    protected:
+        intrometry::pjmsg_shm::ring::Producer producer_;
+        // flushing may be triggered by the user concurrently with the spinning thread
+        std::mutex producer_mutex_;
+        intrometry::SinkStatistics statistics_;
+        SourceHandle statistics_handle_;
+        bool initialized_;
+
+    public:
+        std::atomic<uint32_t> names_version_;
+        std::atomic<uint32_t> source_counter_;
+        intrometry::backend::Clock clock_;
+        intrometry::backend::RateTimer timer_;
+        // shared flush thread mode
+        std::shared_ptr<intrometry::backend::FlushService> flush_service_;
+        std::unique_ptr<intrometry::backend::FlushService::Task> flush_task_;
+        // accessed by the flushing thread only
+        std::chrono::steady_clock::time_point second_deadline_;
+
+        intrometry::backend::SourceContainer<WriterWrapper> sources_;
+        intrometry::backend::SinkCounters counters_;
+        tut::thread::Supervisor<> thread_supervisor_;
+
+    public:
+        explicit Implementation(const Parameters &parameters)
+          : clock_(parameters.clock_), timer_(parameters.rate_, getMaxIdleSteps(parameters, clock_))
+        {
+            names_version_ = intrometry::backend::getRandomUInt32();
+            second_deadline_ = std::chrono::steady_clock::now();
+            source_counter_ = 0;
+
+            initialized_ = producer_.initialize(
+                    intrometry::pjmsg_shm::ring::getSegmentName(parameters.id_), parameters.size_);
+            if (not initialized_)
+            {
+                return;
+            }
+
+            if (parameters.statistics_)
+            {
+                statistics_handle_ = SourceHandle(
+                        this, assign("", statistics_, Source::Parameters(/*persistent_structure=*/true)));
+            }
+
+            if (parameters.shared_threads_ > 0)
+            {
+                share(parameters);
+            }
+            else
+            {
+                thread_supervisor_.add(
+                        tut::thread::Parameters(
+                                tut::thread::Parameters::Restart(/*attempts=*/100, /*sleep_ms=*/50),
+                                tut::thread::Parameters::TerminationPolicy::IGNORE,
+                                tut::thread::Parameters::ExceptionPolicy::CATCH),
+                        &Implementation::spin,
+                        this,
+                        parameters.thread_,
+                        parameters.statistics_);
+            }
+        }
+
+        virtual ~Implementation()
+        {
+            if (flush_task_)
+            {
+                flush_service_->remove(*flush_task_);
+                flush();
+            }
+            thread_supervisor_.interrupt();
+            timer_.interrupt();
+            thread_supervisor_.stop();
+        }
+
+
+        static std::size_t getMaxIdleSteps(const Parameters &parameters, const intrometry::backend::Clock &clock)
+        {
+            if (parameters.statistics_ or clock.raw())
+            {
+                // statistics publishing and clock anchoring
+                return (parameters.rate_);
+            }
+            return (0);
+        }
+
+
+        [[nodiscard]] bool initialized() const
+        {
+            return (initialized_);
+        }
+
+
+        std::shared_ptr<WriterWrapper> assign(
+                const std::string &id,
+                const ariles2::DefaultBase &source,
+                const Source::Parameters &parameters)
+        {
+            return (sources_.tryEmplace(id, source, parameters, names_version_, clock_, source_counter_.fetch_add(1)));
+        }
+
+
+        void spin(const ThreadParameters &thread_parameters, const bool publish_statistics)
+        {
+            const std::string thread_errors = intrometry::backend::configureThread(thread_parameters);
+            if (not thread_errors.empty())
+            {
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            counters_.sampleThread();
+
+            if (timer_.valid())
+            {
+                timer_.start();
+                while (not thread_supervisor_.isInterrupted())
+                {
+                    step(publish_statistics);
+                    intrometry::backend::increment(counters_.flush_overruns_, timer_.step());
+                }
+                flush();
+            }
+            else
+            {
+                thread_supervisor_.log("Incorrect spin rate");
+            }
+            thread_supervisor_.interrupt();
+        }
+
+
+        /// Execute periodic tasks using the process-wide flush service instead of a dedicated thread
+        void share(const Parameters &parameters)
+        {
+            flush_task_ = std::make_unique<intrometry::backend::FlushService::Task>(
+                    parameters.rate_,
+                    getMaxIdleSteps(parameters, clock_),
+                    [this, publish_statistics = parameters.statistics_](const std::size_t skipped_steps)
+                    {
+                        step(publish_statistics);
+                        intrometry::backend::increment(counters_.flush_overruns_, skipped_steps);
+                    });
+            if (not flush_task_->valid())
+            {
+                flush_task_.reset();
+                thread_supervisor_.log("Incorrect spin rate");
+                return;
+            }
+
+            flush_service_ = intrometry::backend::FlushService::get(parameters.shared_threads_, parameters.thread_);
+            const std::string thread_errors = flush_service_->getThreadErrors();
+            if (not thread_errors.empty())
+            {
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            flush_service_->add(*flush_task_);
+        }
+
+
+        void step(const bool publish_statistics)
+        {
+            flush();
+
+            // statistics are published and the clock is re-anchored once per second
+            if (std::chrono::steady_clock::now() >= second_deadline_)
+            {
+                second_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                clock_.anchor();
+                counters_.sampleThread();
+                if (publish_statistics)
+                {
+                    getStatistics(statistics_);
+                    write(statistics_handle_, statistics_, 0);
+                }
+            }
+        }
+
+
+        void notify()
+        {
+            if (flush_task_)
+            {
+                flush_task_->notify();
+            }
+            else
+            {
+                timer_.notify();
+            }
+        }
+
+
+        void flush()
+        {
+            intrometry::backend::increment(counters_.flush_ticks_);
+
+            bool pending = false;
+            {
+                const std::lock_guard lock(producer_mutex_);
+                sources_.visit(
+                        [this, &pending](WriterWrapper &writer)
+                        {
+                            if (not writer.publish(producer_, counters_))
+                            {
+                                pending = true;
+                            }
+                        });
+            }
+            if (pending)
+            {
+                // keep flushing, the sink thread would go idle otherwise
+                notify();
+            }
+        }
+
+
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+        {
+            switch (sources_.write(
+                    id,
+                    source,
+                    [this, &source, &timestamp](WriterWrapper &writer)
+                    {
+                        writer.write(source, timestamp, names_version_);
+                    }))
+            {
+                case intrometry::backend::SourceContainerBase::WriteStatus::ACCEPTED:
+                    notify();
+                    break;
+
+                case intrometry::backend::SourceContainerBase::WriteStatus::UNASSIGNED:
+                    intrometry::backend::increment(counters_.unassigned_);
+                    thread_supervisor_.log(
+                            "Measurement source handler is not assigned, skipping id: ", source.arilesDefaultID());
+                    break;
+            }
+        }
+
+
+        template <class t_Source>
+        void write(const SourceHandle &handle, const t_Source &source, const uint64_t timestamp)
+        {
+            const std::shared_ptr<WriterWrapper> writer = handle.lock<WriterWrapper>(this);
+            if (writer)
+            {
+                writer->write(source, timestamp, names_version_);
+                notify();
+            }
+            else
+            {
+                intrometry::backend::increment(counters_.unassigned_);
+            }
+        }
+
+
+        void getStatistics(SinkStatistics &statistics)
+        {
+            statistics.sources_.clear();
+            sources_.visit(
+                    [&statistics](const WriterWrapper &writer)
+                    {
+                        statistics.sources_.emplace_back();
+                        writer.getStatistics(statistics.sources_.back());
+                    });
+            counters_.get(statistics);
+        }
+    };
+}  // namespace intrometry::pjmsg_shm::sink
+
+
+namespace intrometry::pjmsg_shm
+{
+    Sink::~Sink() = default;
+
+
+    bool Sink::initialize()
+    {
+        if (parameters_.id_.empty())
+        {
+            return (false);
+        }
+        make_pimpl(parameters_);
+        if (not pimpl_->initialized())
+        {
+            pimpl_.reset();
+            return (false);
+        }
+        return (true);
+    }
+
+
+    SourceHandle Sink::assign(
+            const std::string &id,
+            const ariles2::DefaultBase &source,
+            const Source::Parameters &parameters)
+    {
+        if (pimpl_)
+        {
+            return (SourceHandle(pimpl_.get(), pimpl_->assign(id, source, parameters)));
+        }
+        return (SourceHandle());
+    }
+
+
+    void Sink::retract(const std::string &id, const ariles2::DefaultBase &source)
+    {
+        if (pimpl_)
+        {
+            pimpl_->sources_.erase(id, source);
+        }
+    }
+
+
+    void Sink::write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(id, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, sample, timestamp);
+        }
+    }
+
+
+    void Sink::flush()
+    {
+        if (pimpl_)
+        {
+            pimpl_->flush();
+        }
+    }
+
+
+    SinkStatistics Sink::statistics() const
+    {
+        SinkStatistics result;
+        if (pimpl_)
+        {
+            pimpl_->getStatistics(result);
+        }
+        return (result);
+    }
+}  // namespace intrometry::pjmsg_shm
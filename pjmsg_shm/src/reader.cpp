@@ -0,0 +1,80 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <cerrno>
+#include <csignal>
+
+#include "intrometry/pjmsg_shm/reader.h"
+#include "ring.h"
+
+
+namespace intrometry::pjmsg_shm
+{
+    class Reader::Implementation
+    {
+    public:
+        ring::Consumer consumer_;
+        ring::SampleHeader sample_header_;
+    };
+
+
+    Reader::Reader() = default;
+    Reader::~Reader() = default;
+
+
+    bool Reader::initialize(const std::string &id)
+    {
+        std::unique_ptr<Implementation> pimpl = std::make_unique<Implementation>();
+        if (pimpl->consumer_.initialize(ring::getSegmentName(id)))
+        {
+            pimpl_ = std::move(pimpl);
+            return (true);
+        }
+        return (false);
+    }
+
+
+    bool Reader::next(Sample &sample)
+    {
+        if (pimpl_ and pimpl_->consumer_.read(pimpl_->sample_header_, sample.names_, sample.values_))
+        {
+            sample.source_ = pimpl_->sample_header_.source_;
+            sample.stamp_ = pimpl_->sample_header_.stamp_;
+            sample.version_ = pimpl_->sample_header_.version_;
+            return (true);
+        }
+        return (false);
+    }
+
+
+    bool Reader::alive() const
+    {
+        if (not pimpl_)
+        {
+            return (false);
+        }
+
+        const ring::Header &header = pimpl_->consumer_.header();
+        if (0 != header.closed_.load(std::memory_order_acquire))
+        {
+            return (false);
+        }
+        // signal 0 only checks existence of the process
+        return (0 == ::kill(static_cast<pid_t>(header.producer_pid_), 0) or EPERM == errno);
+    }
+
+
+    uint64_t Reader::dropped() const
+    {
+        if (pimpl_)
+        {
+            return (pimpl_->consumer_.header().dropped_.load(std::memory_order_relaxed));
+        }
+        return (0);
+    }
+}  // namespace intrometry::pjmsg_shm
@@ -0,0 +1,162 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Records samples from a shared memory sink to an MCAP file.
+*/
+
+#include <array>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#include <pjmsg_mcap_wrapper/writer.h>
+
+#include "intrometry/backend/utils.h"
+#include "intrometry/pjmsg_shm/reader.h"
+
+
+namespace
+{
+    volatile std::sig_atomic_t interrupted = 0;  // NOLINT
+
+    void handleSignal(const int /*signal*/)
+    {
+        interrupted = 1;
+    }
+
+
+    std::string getDateString()
+    {
+        const std::time_t date_now = std::time(nullptr);
+        std::tm date_tm = {};
+        gmtime_r(&date_now, &date_tm);
+
+        std::array<char, 64> date_string{};
+        if (0 == std::strftime(date_string.data(), date_string.size(), "%Y%m%d_%H%M%S", &date_tm))
+        {
+            return ("");
+        }
+        return (date_string.data());
+    }
+
+
+    pjmsg_mcap_wrapper::Writer::Parameters::Compression getCompression(const std::string &value)
+    {
+        if ("none" == value)
+        {
+            return (pjmsg_mcap_wrapper::Writer::Parameters::Compression::NONE);
+        }
+        if ("zstd" == value)
+        {
+            return (pjmsg_mcap_wrapper::Writer::Parameters::Compression::ZSTD);
+        }
+        throw std::invalid_argument(intrometry::backend::str_concat("Unknown compression: ", value));
+    }
+}  // namespace
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 or argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <sink id> [<directory>] [none|zstd]" << std::endl;  // NOLINT
+        return (EXIT_FAILURE);
+    }
+
+    try
+    {
+        const std::string id = argv[1];                                        // NOLINT
+        const std::filesystem::path directory = (argc > 2) ? argv[2] : ".";  // NOLINT
+        const std::string compression = (argc > 3) ? argv[3] : "zstd";       // NOLINT
+
+        pjmsg_mcap_wrapper::Writer::Parameters writer_parameters;
+        writer_parameters.compression_ = getCompression(compression);
+
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+
+
+        // the sink may be started after the recorder
+        intrometry::pjmsg_shm::Reader reader;
+        while (not reader.initialize(id))
+        {
+            if (0 != interrupted)
+            {
+                return (EXIT_SUCCESS);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+
+        const std::string node_id = intrometry::backend::normalizeId(id);
+        std::filesystem::create_directories(directory);
+        const std::filesystem::path path =
+                directory / intrometry::backend::str_concat("intrometry_", node_id, "_", getDateString(), ".mcap");
+
+        pjmsg_mcap_wrapper::Writer writer;
+        writer.initialize(path, intrometry::backend::str_concat("/intrometry/", node_id), writer_parameters);
+        std::cout << "Recording '" << id << "' to " << path << std::endl;
+
+
+        intrometry::pjmsg_shm::Reader::Sample sample;
+        std::unordered_map<uint32_t, pjmsg_mcap_wrapper::Message> messages;
+        std::size_t skipped = 0;
+
+        for (;;)
+        {
+            // checked before reading so that the ring is drained completely before exiting
+            const bool stop = (0 != interrupted or not reader.alive());
+
+            if (not reader.next(sample))
+            {
+                if (stop)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            pjmsg_mcap_wrapper::Message &message = messages[sample.source_];
+
+            if (not sample.names_.empty())
+            {
+                message.resize(sample.names_.size());
+                for (std::size_t i = 0; i < sample.names_.size(); ++i)
+                {
+                    message.name(i) = sample.names_[i];
+                }
+                message.setVersion(sample.version_);
+            }
+
+            // names of this version have not been received yet
+            if (message.getVersion() != sample.version_ or message.size() != sample.values_.size())
+            {
+                ++skipped;
+                continue;
+            }
+
+            for (std::size_t i = 0; i < sample.values_.size(); ++i)
+            {
+                message.value(i) = sample.values_[i];
+            }
+            message.setStamp(sample.stamp_);
+            writer.write(message);
+        }
+
+        std::cout << "Dropped by sink: " << reader.dropped() << ", skipped without names: " << skipped << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
@@ -0,0 +1,495 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+
+    @brief Shared memory ring: layout, producer and consumer.
+
+    The segment consists of a header followed by a byte ring of variable size
+    records. There is a single producer (sink flushing thread) and a single
+    consumer (recorder), positions in the ring are monotonically increasing
+    byte counters. A record becomes visible to the consumer only after it is
+    completely written, so data in the ring remains consistent if the
+    producer crashes. Records do not wrap around the end of the ring: the
+    remaining space is filled with a padding record instead.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "intrometry/backend/utils.h"
+
+
+namespace intrometry::pjmsg_shm::ring
+{
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Lock-free atomics are required in shared memory");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Lock-free atomics are required in shared memory");
+
+
+    constexpr uint64_t MAGIC = 0x72746d6f72746e69;  // "intromtr"
+    constexpr uint32_t LAYOUT_VERSION = 1;
+    constexpr uint64_t ALIGNMENT = 8;
+
+
+    inline constexpr uint64_t align(const uint64_t size)
+    {
+        return ((size + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+    }
+
+
+    inline std::string getSegmentName(const std::string &id)
+    {
+        return (intrometry::backend::str_concat("/intrometry_", intrometry::backend::normalizeId(id)));
+    }
+
+
+    class Header
+    {
+    public:
+        std::atomic<uint64_t> magic_;
+        uint32_t layout_version_;
+        /// process id of the producer
+        uint32_t producer_pid_;
+        /// size of the ring in bytes
+        uint64_t capacity_;
+
+        /// set by the producer on graceful detachment
+        std::atomic<uint32_t> closed_;
+        /// incremented by consumers on attachment, names are republished on change
+        std::atomic<uint32_t> consumer_generation_;
+        /// samples dropped by the producer due to lack of space
+        std::atomic<uint64_t> dropped_;
+
+        alignas(64) std::atomic<uint64_t> head_;
+        alignas(64) std::atomic<uint64_t> tail_;
+    };
+
+
+    enum class RecordType : uint32_t
+    {
+        PADDING = 0,
+        SAMPLE = 1
+    };
+
+
+    class RecordHeader
+    {
+    public:
+        /// full size of the record including this header, aligned
+        uint32_t size_;
+        RecordType type_;
+    };
+
+
+    /**
+     * Followed by a names block (if names_size_ > 0): a uint32_t length and
+     * characters of each name, padded to alignment; and an array of values.
+     */
+    class SampleHeader
+    {
+    public:
+        uint64_t stamp_;
+        uint32_t source_;
+        uint32_t version_;
+        /// number of values
+        uint32_t size_;
+        /// size of the names block in bytes, names are omitted if 0
+        uint32_t names_size_;
+    };
+
+
+    /// Mapping of a shared memory segment
+    class Segment
+    {
+    protected:
+        std::string name_;
+        void *memory_ = MAP_FAILED;
+        std::size_t size_ = 0;
+        bool owner_ = false;
+
+    protected:
+        bool map(const int fd, const std::size_t size)
+        {
+            memory_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (MAP_FAILED == memory_)
+            {
+                return (false);
+            }
+            size_ = size;
+            return (true);
+        }
+
+    public:
+        Segment() = default;
+        Segment(const Segment &) = delete;
+        Segment &operator=(const Segment &) = delete;
+
+        ~Segment()
+        {
+            if (MAP_FAILED != memory_)
+            {
+                if (owner_)
+                {
+                    header()->closed_.store(1, std::memory_order_release);
+                }
+                ::munmap(memory_, size_);
+            }
+            if (owner_)
+            {
+                // consumers keep their mappings
+                ::shm_unlink(name_.c_str());
+            }
+        }
+
+        [[nodiscard]] static uint64_t getDataOffset()
+        {
+            return ((sizeof(Header) + 63) & ~static_cast<uint64_t>(63));  // NOLINT
+        }
+
+        /// @return true if the segment exists and its producer has not detached or exited
+        [[nodiscard]] static bool isActive(const std::string &name)
+        {
+            Segment segment;
+            if (not segment.open(name) or 0 != segment.header()->closed_.load(std::memory_order_acquire))
+            {
+                return (false);
+            }
+            // signal 0 only checks existence of the process
+            return (0 == ::kill(static_cast<pid_t>(segment.header()->producer_pid_), 0) or EPERM == errno);
+        }
+
+        /**
+         * Create a new segment, a stale segment with the same name is
+         * replaced, fails if the segment is used by a running producer.
+         */
+        bool create(const std::string &name, const uint64_t capacity)
+        {
+            name_ = name;
+
+            if (isActive(name_))
+            {
+                return (false);
+            }
+            ::shm_unlink(name_.c_str());
+            const int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+            {
+                return (false);
+            }
+            owner_ = true;
+
+            const std::size_t size = getDataOffset() + align(capacity);
+            if (0 != ::ftruncate(fd, static_cast<off_t>(size)))
+            {
+                ::close(fd);
+                return (false);
+            }
+            if (not map(fd, size))
+            {
+                return (false);
+            }
+
+            Header *header = new (memory_) Header;
+            header->layout_version_ = LAYOUT_VERSION;
+            header->producer_pid_ = static_cast<uint32_t>(::getpid());
+            header->capacity_ = align(capacity);
+            header->closed_ = 0;
+            header->consumer_generation_ = 0;
+            header->dropped_ = 0;
+            header->head_ = 0;
+            header->tail_ = 0;
+            // consumers check it last
+            header->magic_.store(MAGIC, std::memory_order_release);
+
+            return (true);
+        }
+
+        /// Attach to an existing segment
+        bool open(const std::string &name)
+        {
+            name_ = name;
+
+            const int fd = ::shm_open(name_.c_str(), O_RDWR | O_CLOEXEC, 0);
+            if (fd < 0)
+            {
+                return (false);
+            }
+
+            struct stat segment_stat = {};
+            if (0 != ::fstat(fd, &segment_stat)
+                or static_cast<uint64_t>(segment_stat.st_size) < getDataOffset() + ALIGNMENT)
+            {
+                ::close(fd);
+                return (false);
+            }
+            if (not map(fd, static_cast<std::size_t>(segment_stat.st_size)))
+            {
+                return (false);
+            }
+
+            const Header *segment_header = header();
+            return (
+                    MAGIC == segment_header->magic_.load(std::memory_order_acquire)
+                    and LAYOUT_VERSION == segment_header->layout_version_
+                    and isValidCapacity(segment_header->capacity_));
+        }
+
+        /// capacity is read from the header, which may be overwritten after attachment
+        [[nodiscard]] bool isValidCapacity(const uint64_t capacity) const
+        {
+            return (capacity >= ALIGNMENT and align(capacity) == capacity and getDataOffset() + capacity <= size_);
+        }
+
+        [[nodiscard]] Header *header() const
+        {
+            return (static_cast<Header *>(memory_));
+        }
+
+        [[nodiscard]] uint8_t *data() const
+        {
+            return (static_cast<uint8_t *>(memory_) + getDataOffset());
+        }
+    };
+
+
+    class Producer
+    {
+    protected:
+        Segment segment_;
+        Header *header_ = nullptr;
+        uint8_t *data_ = nullptr;
+
+    protected:
+        void write(uint64_t &offset, const void *source, const std::size_t size)
+        {
+            std::memcpy(data_ + offset, source, size);
+            offset += size;
+        }
+
+    public:
+        bool initialize(const std::string &name, const uint64_t capacity)
+        {
+            if (segment_.create(name, capacity))
+            {
+                header_ = segment_.header();
+                data_ = segment_.data();
+                return (true);
+            }
+            return (false);
+        }
+
+        [[nodiscard]] uint32_t getConsumerGeneration() const
+        {
+            return (header_->consumer_generation_.load(std::memory_order_relaxed));
+        }
+
+        /// @return false if there is not enough space in the ring, the sample is dropped
+        bool write(
+                const uint64_t stamp,
+                const uint32_t source,
+                const uint32_t version,
+                const std::vector<std::string> *names,
+                const std::vector<double> &values)
+        {
+            uint64_t names_size = 0;
+            if (nullptr != names)
+            {
+                for (const std::string &name : *names)
+                {
+                    names_size += sizeof(uint32_t) + name.size();
+                }
+                names_size = align(names_size);
+            }
+            const uint64_t record_size =
+                    align(sizeof(RecordHeader) + sizeof(SampleHeader) + names_size + values.size() * sizeof(double));
+
+            const uint64_t capacity = header_->capacity_;
+            uint64_t head = header_->head_.load(std::memory_order_relaxed);
+            const uint64_t tail = header_->tail_.load(std::memory_order_acquire);
+
+            uint64_t offset = head % capacity;
+            const uint64_t padding = (capacity - offset < record_size) ? capacity - offset : 0;
+
+            if (record_size > capacity or head + padding + record_size - tail > capacity)
+            {
+                intrometry::backend::increment(header_->dropped_);
+                return (false);
+            }
+
+            if (padding > 0)
+            {
+                const RecordHeader padding_header{ static_cast<uint32_t>(padding), RecordType::PADDING };
+                write(offset, &padding_header, sizeof(padding_header));
+                head += padding;
+                offset = 0;
+            }
+
+            const RecordHeader record_header{ static_cast<uint32_t>(record_size), RecordType::SAMPLE };
+            write(offset, &record_header, sizeof(record_header));
+
+            const SampleHeader sample_header{
+                stamp, source, version, static_cast<uint32_t>(values.size()), static_cast<uint32_t>(names_size)
+            };
+            write(offset, &sample_header, sizeof(sample_header));
+
+            if (nullptr != names)
+            {
+                const uint64_t names_end = offset + names_size;
+                for (const std::string &name : *names)
+                {
+                    const uint32_t length = name.size();
+                    write(offset, &length, sizeof(length));
+                    write(offset, name.data(), name.size());
+                }
+                offset = names_end;
+            }
+            write(offset, values.data(), values.size() * sizeof(double));
+
+            // publish the record
+            header_->head_.store(head + record_size, std::memory_order_release);
+            return (true);
+        }
+    };
+
+
+    class Consumer
+    {
+    protected:
+        Segment segment_;
+        Header *header_ = nullptr;
+        const uint8_t *data_ = nullptr;
+        /// validated on attachment, the copy in the header may be overwritten
+        uint64_t capacity_ = 0;
+
+    protected:
+        void read(uint64_t &offset, void *destination, const std::size_t size) const
+        {
+            std::memcpy(destination, data_ + offset, size);
+            offset += size;
+        }
+
+    public:
+        bool initialize(const std::string &name)
+        {
+            if (segment_.open(name))
+            {
+                header_ = segment_.header();
+                data_ = segment_.data();
+                capacity_ = header_->capacity_;
+                if (segment_.isValidCapacity(capacity_))
+                {
+                    header_->consumer_generation_.fetch_add(1, std::memory_order_relaxed);
+                    return (true);
+                }
+            }
+            return (false);
+        }
+
+        [[nodiscard]] const Header &header() const
+        {
+            return (*header_);
+        }
+
+        /**
+         * @return false if there are no complete records
+         * @throw std::runtime_error if the ring is corrupted
+         */
+        bool read(
+                SampleHeader &sample_header,
+                std::vector<std::string> &names,
+                std::vector<double> &values)
+        {
+            const uint64_t capacity = capacity_;
+            uint64_t tail = header_->tail_.load(std::memory_order_relaxed);
+
+            for (;;)
+            {
+                const uint64_t head = header_->head_.load(std::memory_order_acquire);
+                if (tail == head)
+                {
+                    return (false);
+                }
+
+                if (tail != align(tail))
+                {
+                    throw std::runtime_error("Corrupted shared memory ring");
+                }
+
+                uint64_t offset = tail % capacity;
+                RecordHeader record_header{};
+                read(offset, &record_header, sizeof(record_header));
+
+                if (record_header.size_ < sizeof(RecordHeader) or record_header.size_ > capacity - tail % capacity
+                    or record_header.size_ > head - tail)
+                {
+                    throw std::runtime_error("Corrupted shared memory ring");
+                }
+
+                if (RecordType::SAMPLE == record_header.type_)
+                {
+                    // all sizes are checked against the record, the segment may be written by any process
+                    const uint64_t record_end = tail % capacity + record_header.size_;
+                    if (offset + sizeof(sample_header) > record_end)
+                    {
+                        throw std::runtime_error("Corrupted shared memory ring");
+                    }
+                    read(offset, &sample_header, sizeof(sample_header));
+
+                    const uint64_t names_end = offset + sample_header.names_size_;
+                    if (names_end + static_cast<uint64_t>(sample_header.size_) * sizeof(double) > record_end)
+                    {
+                        throw std::runtime_error("Corrupted shared memory ring");
+                    }
+
+                    names.clear();
+                    if (sample_header.names_size_ > 0)
+                    {
+                        names.resize(sample_header.size_);
+                        for (std::string &name : names)
+                        {
+                            uint32_t length = 0;
+                            if (offset + sizeof(length) > names_end)
+                            {
+                                throw std::runtime_error("Corrupted shared memory ring");
+                            }
+                            read(offset, &length, sizeof(length));
+                            if (offset + length > names_end)
+                            {
+                                throw std::runtime_error("Corrupted shared memory ring");
+                            }
+                            name.assign(reinterpret_cast<const char *>(data_ + offset), length);  // NOLINT
+                            offset += length;
+                        }
+                        offset = names_end;
+                    }
+
+                    values.resize(sample_header.size_);
+                    read(offset, values.data(), values.size() * sizeof(double));
+                }
+
+                tail += record_header.size_;
+                header_->tail_.store(tail, std::memory_order_release);
+
+                if (RecordType::SAMPLE == record_header.type_)
+                {
+                    return (true);
+                }
+            }
+        }
+    };
+}  // namespace intrometry::pjmsg_shm::ring
@@ -13,6 +13,12 @@
 #include <intrometry/backend/utils.h>
 
 
+namespace rclcpp
+{
+    class Node;
+}  // namespace rclcpp
+
+
 namespace intrometry::pjmsg_topic
 {
     namespace sink
@@ -28,6 +34,45 @@ namespace intrometry::pjmsg_topic
             /// id of the sink, disables publishing if empty
             std::string id_;
 
+            /// publish sink statistics as an extra source once per second
+            bool statistics_;
+
+            /// clock used to timestamp data written without explicit timestamps
+            Clock clock_;
+
+            /// placement of the sink thread
+            ThreadParameters thread_;
+
+            /**
+             * size of the process-wide pool of threads shared by all sinks of
+             * this backend that enable it, sinks are flushed at their own
+             * rates; the pool is created by the first sink with its `thread`
+             * parameters and stopped with the last one. 0 -- dedicated
+             * thread.
+             */
+            std::size_t shared_threads_;
+
+            /**
+             * Samples are never published while there are no subscribers to
+             * values, if enabled, write() also drops samples without
+             * flattening them in this case.
+             */
+            bool on_demand_;
+
+            /**
+             * Application node used for publishing instead of a dedicated
+             * node, topics are resolved in its namespace. The node is not
+             * spun by the sink.
+             */
+            std::shared_ptr<rclcpp::Node> node_;
+
+            /**
+             * Publish using a process-wide node, which is shared by all sinks
+             * that enable it, instead of a dedicated node, ignored if `node`
+             * is given. The node is not spun by the sink.
+             */
+            bool shared_node_;
+
         public:
             // cppcheck-suppress noExplicitConstructor
             Parameters(const std::string &id = "");  // NOLINT
@@ -36,6 +81,13 @@ namespace intrometry::pjmsg_topic
 
             Parameters &rate(const std::size_t value);
             Parameters &id(const std::string &value);
+            Parameters &statistics(const bool value);
+            Parameters &clock(const Clock &value);
+            Parameters &thread(const ThreadParameters &value);
+            Parameters &shared_threads(const std::size_t value);
+            Parameters &on_demand(const bool value);
+            Parameters &node(const std::shared_ptr<rclcpp::Node> &value);
+            Parameters &shared_node(const bool value);
         };
 
         class Implementation;
@@ -55,12 +107,15 @@ namespace intrometry::pjmsg_topic
         ~Sink();
 
         bool initialize();
-        void assign(
+        SourceHandle assign(
                 const std::string &id,
                 const ariles2::DefaultBase &source,
                 const Source::Parameters &parameters = Source::Parameters());
         void retract(const std::string &id, const ariles2::DefaultBase &source);
         void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp = 0);
+        void write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp = 0);
         void flush();
+        [[nodiscard]] SinkStatistics statistics() const;
     };
 }  // namespace intrometry::pjmsg_topic
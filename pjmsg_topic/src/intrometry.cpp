@@ -8,6 +8,7 @@
 
 #include <unordered_map>
 #include <atomic>
+#include <chrono>
 
 #include <ariles2/visitors/namevalue2.h>
 #include <thread_supervisor/supervisor.h>
@@ -45,9 +46,15 @@ namespace
     public:
         std::shared_ptr<Message> message_in_;
         std::shared_ptr<Message> message_out_;
-        std::size_t previous_size_ = 0;
+        intrometry::backend::StructureTracker structure_;
         bool new_names_version_ = false;
 
+        // stamps of messages, raw stamps are clock readings converted by the consumer
+        uint64_t stamp_in_ = 0;
+        uint64_t stamp_out_ = 0;
+        bool raw_in_ = false;
+        bool raw_out_ = false;
+
     public:
         NameValueContainer()
         {
@@ -60,35 +67,42 @@ namespace
             const bool publish_names = new_names_version_;
             if (new_names_version_)
             {
-                // message_out_->names_ = message_in_->names_;
-                message_out_->names_.names.resize(message_in_->names_.names.size());
+                // names of persistent sources are not regenerated on writes
+                message_out_->names_.names = message_in_->names_.names;
                 message_out_->values_.values.resize(message_out_->names_.names.size());
                 message_out_->names_.names_version = message_in_->names_.names_version;
                 message_out_->values_.names_version = message_out_->names_.names_version;
                 new_names_version_ = false;
             }
             std::swap(message_out_, message_in_);
+            std::swap(stamp_out_, stamp_in_);
+            std::swap(raw_out_, raw_in_);
             return publish_names;
         }
 
-        void finalize(
-                const bool persistent_structure,
-                const rclcpp::Time &timestamp,
-                std::atomic<uint32_t> &names_version)
+        /// @return true if names have changed
+        bool finalize(const bool persistent_structure, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
         {
-            message_in_->names_.header.stamp = timestamp;
-            message_in_->values_.header.stamp = timestamp;
+            setStamp(*message_in_, timestamp);
+            stamp_in_ = timestamp;
+            raw_in_ = false;
 
-            // we cannot know for sure that the names have not changed
-            // without comparing all the names, do our best
-            if (not persistent_structure or previous_size_ != size())
+            const bool names_changed = structure_.update(message_in_->names_.names, persistent_structure);
+            if (names_changed)
             {
                 message_in_->names_.names_version = names_version.fetch_add(1);
                 message_in_->values_.names_version = message_in_->names_.names_version;
                 new_names_version_ = true;
             }
 
-            previous_size_ = size();
+            return (names_changed);
+        }
+
+        static void setStamp(Message &message, const uint64_t timestamp)
+        {
+            const rclcpp::Time stamp(static_cast<rcl_time_point_value_t>(timestamp));
+            message.names_.header.stamp = stamp;
+            message.values_.header.stamp = stamp;
         }
 
         std::string &name(const std::size_t index)
@@ -132,60 +146,226 @@ namespace
         std::mutex mutex_out_;
         std::atomic<bool> flushed_;
 
+        // aggregation mode: min / max / mean series are published as a separate message
+        std::unique_ptr<intrometry::backend::Aggregator> aggregator_;
+        Message aggregate_;
+        // version of names the aggregate names are generated from
+        uint32_t aggregate_source_version_;
+        std::atomic<uint32_t> &names_version_;
+        const intrometry::backend::Clock &clock_;
+
+        intrometry::backend::SourceCounters counters_;
+        // version of the last written intrometry::Sample
+        uint64_t sample_version_;
+        // subscription generation the names were last published for, protected by mutex_out_
+        uint32_t published_generation_;
+
     public:
         WriterWrapper(
                 const ariles2::DefaultBase &source,
                 std::string id,
-                const bool persistent_structure,
-                std::atomic<uint32_t> &names_version)
-          : id_(std::move(id)), data_(std::make_shared<NameValueContainer>()), writer_(data_)
+                const intrometry::Source::Parameters &parameters,
+                std::atomic<uint32_t> &names_version,
+                const intrometry::backend::Clock &clock)
+          : id_(std::move(id))
+          , data_(std::make_shared<NameValueContainer>())
+          , writer_(data_)
+          , names_version_(names_version)
+          , clock_(clock)
+          , sample_version_(0)
+          , published_generation_(0)
         {
             writer_parameters_ = writer_.getDefaultParameters();
-            if (persistent_structure)
+            if (parameters.persistent_structure_)
             {
                 writer_parameters_.persistent_structure_ = true;
             }
 
-            // write to allocate memory
-            ariles2::apply(writer_, source, id_);
-            data_->finalize(writer_parameters_.persistent_structure_, rclcpp::Time(0), names_version);
+            // write to allocate memory and generate names
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            data_->finalize(writer_parameters_.persistent_structure_, 0, names_version);
+
+            if (parameters.aggregate_)
+            {
+                aggregator_ = std::make_unique<intrometry::backend::Aggregator>();
+            }
+            aggregate_source_version_ = data_->message_in_->names_.names_version + 1;
 
             flushed_ = true;  // do not publish on assignment
         }
 
 
-        void publish(const NamesPublisherPtr &names_sink, const ValuesPublisherPtr &values_sink)
+        /**
+         * @param[in] generation names are republished when the subscription generation changes
+         * @return false if data is left for the next flush, i.e., the source is busy
+         */
+        bool publish(
+                const NamesPublisherPtr &names_sink,
+                const ValuesPublisherPtr &values_sink,
+                const uint32_t generation)
         {
             if (not flushed_)
             {
-                if (mutex_in_.try_lock() && mutex_out_.try_lock())
+                if (mutex_out_.try_lock())
                 {
-                    const bool publish_names = data_->swap();
-                    mutex_in_.unlock();
-                    if (publish_names)
+                    if (mutex_in_.try_lock())
+                    {
+                        const bool publish_names = (data_->swap() or published_generation_ != generation);
+                        if (publish_names)
+                        {
+                            published_generation_ = generation;
+                            // aggregate names are republished as well
+                            aggregate_source_version_ = data_->message_out_->names_.names_version + 1;
+                        }
+                        if (aggregator_)
+                        {
+                            aggregator_->swap();
+                        }
+                        flushed_ = true;
+                        mutex_in_.unlock();
+
+                        if (data_->raw_out_)
+                        {
+                            data_->stamp_out_ = clock_.toNanoseconds(data_->stamp_out_);
+                            data_->raw_out_ = false;
+                            NameValueContainer::setStamp(*data_->message_out_, data_->stamp_out_);
+                        }
+
+                        std::size_t bytes = data_->message_out_->values_.values.size() * sizeof(double);
+                        if (publish_names)
+                        {
+                            names_sink->publish(data_->message_out_->names_);
+                            for (const std::string &name : data_->message_out_->names_.names)
+                            {
+                                bytes += name.size();
+                            }
+                        }
+                        values_sink->publish(data_->message_out_->values_);
+                        if (aggregator_)
+                        {
+                            bytes += aggregate(names_sink, values_sink);
+                        }
+
+                        intrometry::backend::increment(counters_.flushed_);
+                        intrometry::backend::increment(counters_.bytes_, bytes);
+                    }
+                    else
                     {
-                        names_sink->publish(data_->message_out_->names_);
+                        intrometry::backend::increment(counters_.flush_busy_);
                     }
-                    values_sink->publish(data_->message_out_->values_);
-                    flushed_ = true;
                     mutex_out_.unlock();
                 }
+                else
+                {
+                    intrometry::backend::increment(counters_.flush_busy_);
+                }
             }
+            return (flushed_.load());
         }
 
 
-        void write(
-                const ariles2::DefaultBase &source,
-                const rclcpp::Time &timestamp,
-                std::atomic<uint32_t> &names_version)
+        /// @param[in] timestamp nanoseconds since epoch, 0 -- use clock
+        /// @param[in] source ariles class or intrometry::Sample
+        template <class t_Source>
+        void write(const t_Source &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
         {
+            // conversion of raw clock readings is deferred to the consumer
+            const bool raw = (0 == timestamp and clock_.raw());
+            const uint64_t stamp = (0 == timestamp) ? clock_.ticks() : timestamp;
+
             if (mutex_in_.try_lock())
             {
-                ariles2::apply(writer_, source, id_);
-                data_->finalize(writer_parameters_.persistent_structure_, timestamp, names_version);
-                flushed_ = false;
+                flatten(source, stamp, names_version);
+                data_->raw_in_ = raw;
+                if (aggregator_)
+                {
+                    aggregator_->fold(data_->message_in_->values_.values);
+                }
+                if (not flushed_.exchange(false))
+                {
+                    intrometry::backend::increment(counters_.overwritten_);
+                }
+                intrometry::backend::increment(counters_.accepted_);
                 mutex_in_.unlock();
             }
+            else
+            {
+                intrometry::backend::increment(counters_.dropped_busy_);
+            }
+        }
+
+
+        /// Drop pending sample without publishing
+        /// @return true if a sample was dropped
+        bool discard()
+        {
+            return (not flushed_.exchange(true));
+        }
+
+
+        void getStatistics(intrometry::SourceStatistics &statistics) const
+        {
+            counters_.get(statistics);
+            statistics.id_ = id_;
+        }
+
+    protected:
+        void flatten(const ariles2::DefaultBase &source, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            // names of persistent sources are generated only in the first pass
+            ariles2::apply(writer_, source, id_, writer_parameters_);
+            if (data_->finalize(writer_parameters_.persistent_structure_, timestamp, names_version)
+                and writer_parameters_.persistent_structure_)
+            {
+                // structure has changed, traverse again to generate names
+                ariles2::apply(writer_, source, id_);
+            }
+        }
+
+        void flatten(const intrometry::Sample &sample, const uint64_t timestamp, std::atomic<uint32_t> &names_version)
+        {
+            const bool names_changed = intrometry::backend::copySample(*data_, sample, sample_version_);
+            data_->finalize(writer_parameters_.persistent_structure_ and not names_changed, timestamp, names_version);
+        }
+
+        /// @return number of published bytes
+        std::size_t aggregate(const NamesPublisherPtr &names_sink, const ValuesPublisherPtr &values_sink)
+        {
+            const intrometry::backend::Aggregator::Window &window = aggregator_->window();
+            const Message &message = *(data_->message_out_);
+            if (0 == window.count_ or window.sum_.size() != message.names_.names.size())
+            {
+                return (0);
+            }
+
+            std::size_t bytes = 0;
+            const rclcpp::Time stamp(static_cast<rcl_time_point_value_t>(data_->stamp_out_));
+            if (aggregate_source_version_ != message.names_.names_version)
+            {
+                // aggregate names have their own version
+                aggregate_source_version_ = message.names_.names_version;
+                aggregate_.names_.names.clear();
+                for (const char *suffix : intrometry::backend::Aggregator::SUFFIXES)
+                {
+                    for (const std::string &name : message.names_.names)
+                    {
+                        aggregate_.names_.names.push_back(intrometry::backend::str_concat(name, suffix));
+                        bytes += aggregate_.names_.names.back().size();
+                    }
+                }
+                aggregate_.values_.values.resize(aggregate_.names_.names.size());
+                aggregate_.names_.names_version = names_version_.fetch_add(1);
+                aggregate_.values_.names_version = aggregate_.names_.names_version;
+                aggregate_.names_.header.stamp = stamp;
+                names_sink->publish(aggregate_.names_);
+            }
+
+            aggregator_->get([this](const std::size_t index) -> double &
+                             { return (aggregate_.values_.values[index]); });  // NOLINT
+            aggregate_.values_.header.stamp = stamp;
+            values_sink->publish(aggregate_.values_);
+
+            return (bytes + aggregate_.values_.values.size() * sizeof(double));
         }
     };
 }  // namespace
@@ -196,12 +376,26 @@ namespace intrometry::pjmsg_topic::sink
     {
         rate_ = 500;
         id_ = id;
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+        on_demand_ = false;
+        node_ = nullptr;
+        shared_node_ = false;
     }
 
     Parameters::Parameters(const char *id)
     {
         rate_ = 500;
         id_ = id;
+        statistics_ = false;
+        clock_ = Clock();
+        thread_ = ThreadParameters();
+        shared_threads_ = 0;
+        on_demand_ = false;
+        node_ = nullptr;
+        shared_node_ = false;
     }
 
     Parameters &Parameters::rate(const std::size_t value)
@@ -215,6 +409,48 @@ namespace intrometry::pjmsg_topic::sink
         id_ = value;
         return (*this);
     }
+
+    Parameters &Parameters::statistics(const bool value)
+    {
+        statistics_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::clock(const Clock &value)
+    {
+        clock_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::thread(const ThreadParameters &value)
+    {
+        thread_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::shared_threads(const std::size_t value)
+    {
+        shared_threads_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::on_demand(const bool value)
+    {
+        on_demand_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::node(const std::shared_ptr<rclcpp::Node> &value)
+    {
+        node_ = value;
+        return (*this);
+    }
+
+    Parameters &Parameters::shared_node(const bool value)
+    {
+        shared_node_ = value;
+        return (*this);
+    }
 }  // namespace intrometry::pjmsg_topic::sink
 
 namespace
@@ -249,6 +485,39 @@ namespace
             initialized_ = true;
         }
     };
+
+
+    std::shared_ptr<rclcpp::Node> createNode(const std::string &name)
+    {
+        return (std::make_shared<rclcpp::Node>(
+                name,
+                // try to be stealthy and use minimal resources
+                rclcpp::NodeOptions()
+                        .enable_topic_statistics(false)
+                        .start_parameter_services(false)
+                        .start_parameter_event_publisher(false)
+                        .append_parameter_override("use_sim_time", false)
+                        .use_clock_thread(false)
+                        .enable_rosout(false)));
+    }
+
+
+    /// Process-wide node, created on the first call and destroyed with the last reference
+    std::shared_ptr<rclcpp::Node> getSharedNode()
+    {
+        static std::mutex mutex;
+        static std::weak_ptr<rclcpp::Node> node;
+
+        const std::lock_guard lock(mutex);
+        std::shared_ptr<rclcpp::Node> result = node.lock();
+        if (not result)
+        {
+            result = createNode(
+                    intrometry::backend::str_concat("intrometry_", intrometry::backend::getRandomId(8)));
+            node = result;
+        }
+        return (result);
+    }
 }  // namespace
 
 
@@ -258,40 +527,65 @@ namespace intrometry::pjmsg_topic::sink
     {
     public:
         std::shared_ptr<rclcpp::Node> node_;
-        rclcpp::executors::SingleThreadedExecutor executor_;
+        // dedicated node only
+        std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> executor_;
 
     protected:
         NamesPublisherPtr names_publisher_;
         ValuesPublisherPtr values_publisher_;
+        intrometry::SinkStatistics statistics_;
+        SourceHandle statistics_handle_;
 
     public:
         std::atomic<uint32_t> names_version_;
+        // subscribers of values, updated on flush
+        std::atomic<bool> subscribed_;
+        // incremented when subscribers appear, names are republished for each generation
+        std::atomic<uint32_t> subscription_generation_;
+        const bool on_demand_;  // NOLINT
+        intrometry::backend::Clock clock_;
+        intrometry::backend::RateTimer timer_;
+        // shared flush thread mode
+        std::shared_ptr<intrometry::backend::FlushService> flush_service_;
+        std::unique_ptr<intrometry::backend::FlushService::Task> flush_task_;
+        // accessed by the flushing thread only
+        std::chrono::steady_clock::time_point second_deadline_;
 
         intrometry::backend::SourceContainer<WriterWrapper> sources_;
+        intrometry::backend::SinkCounters counters_;
         tut::thread::Supervisor<ROSLogger> thread_supervisor_;
 
     public:
-        Implementation(const std::string &sink_id, const std::size_t rate)
+        explicit Implementation(const Parameters &parameters)
+          : on_demand_(parameters.on_demand_)
+          , clock_(parameters.clock_)
+          , timer_(parameters.rate_, getMaxIdleSteps(parameters, clock_))
         {
             names_version_ = intrometry::backend::getRandomUInt32();
+            second_deadline_ = std::chrono::steady_clock::now();
+            subscribed_ = false;
+            subscription_generation_ = 0;
 
-            const std::string node_id = intrometry::backend::normalizeId(sink_id);
+            const std::string node_id = intrometry::backend::normalizeId(parameters.id_);
             const std::string random_id = intrometry::backend::getRandomId(8);
             const std::string topic_prefix =
                     intrometry::backend::str_concat("intrometry/", node_id.empty() ? random_id : node_id);
 
-            node_ = std::make_shared<rclcpp::Node>(
-                    intrometry::backend::str_concat("intrometry_", node_id, "_", random_id),
-                    // try to be stealthy and use minimal resources
-                    rclcpp::NodeOptions()
-                            .enable_topic_statistics(false)
-                            .start_parameter_services(false)
-                            .start_parameter_event_publisher(false)
-                            .append_parameter_override("use_sim_time", false)
-                            .use_clock_thread(false)
-                            .enable_rosout(false));
+            if (parameters.node_)
+            {
+                node_ = parameters.node_;
+            }
+            else if (parameters.shared_node_)
+            {
+                node_ = getSharedNode();
+            }
+            else
+            {
+                node_ = createNode(intrometry::backend::str_concat("intrometry_", node_id, "_", random_id));
+                executor_ = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+                executor_->add_node(node_);
+            }
             thread_supervisor_.initializeLogger(node_);
-            executor_.add_node(node_);
 
             names_publisher_ = node_->create_publisher<NamesMsg>(
                     intrometry::backend::str_concat(topic_prefix, "/names"),
@@ -300,37 +594,74 @@ namespace intrometry::pjmsg_topic::sink
                     intrometry::backend::str_concat(topic_prefix, "/values"),
                     rclcpp::QoS(/*history_depth=*/20).best_effort().durability_volatile());
 
+            if (parameters.statistics_)
+            {
+                statistics_handle_ = SourceHandle(
+                        this,
+                        sources_.tryEmplace(
+                                "",
+                                statistics_,
+                                Source::Parameters(/*persistent_structure=*/true),
+                                names_version_,
+                                clock_));
+            }
+
 
-            thread_supervisor_.add(
-                    tut::thread::Parameters(
-                            tut::thread::Parameters::Restart(/*attempts=*/100, /*sleep_ms=*/50),
-                            tut::thread::Parameters::TerminationPolicy::IGNORE,
-                            tut::thread::Parameters::ExceptionPolicy::CATCH),
-                    &Implementation::spin,
-                    this,
-                    rate);
+            if (parameters.shared_threads_ > 0)
+            {
+                share(parameters);
+            }
+            else
+            {
+                thread_supervisor_.add(
+                        tut::thread::Parameters(
+                                tut::thread::Parameters::Restart(/*attempts=*/100, /*sleep_ms=*/50),
+                                tut::thread::Parameters::TerminationPolicy::IGNORE,
+                                tut::thread::Parameters::ExceptionPolicy::CATCH),
+                        &Implementation::spin,
+                        this,
+                        parameters.thread_,
+                        parameters.statistics_);
+            }
         }
 
         virtual ~Implementation()
         {
+            if (flush_task_)
+            {
+                flush_service_->remove(*flush_task_);
+                flush();
+            }
+            thread_supervisor_.interrupt();
+            timer_.interrupt();
             thread_supervisor_.stop();
         }
 
 
-        void spin(const std::size_t rate)
+        static std::size_t getMaxIdleSteps(const Parameters &parameters, const intrometry::backend::Clock & /*clock*/)
         {
-            intrometry::backend::RateTimer timer(rate);
+            // the executor is spun and subscribers are checked at least once per second
+            return (parameters.rate_);
+        }
 
-            if (timer.valid())
+
+        void spin(const ThreadParameters &thread_parameters, const bool publish_statistics)
+        {
+            const std::string thread_errors = intrometry::backend::configureThread(thread_parameters);
+            if (not thread_errors.empty())
             {
-                timer.start();
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            counters_.sampleThread();
 
+            if (timer_.valid())
+            {
+                timer_.start();
                 while (rclcpp::ok() and not thread_supervisor_.isInterrupted())
                 {
-                    flush();
-                    executor_.spin_some();
-
-                    timer.step();
+                    step(publish_statistics);
+                    intrometry::backend::increment(counters_.flush_overruns_, timer_.step());
                 }
                 flush();
             }
@@ -342,10 +673,199 @@ namespace intrometry::pjmsg_topic::sink
         }
 
 
+        /// Execute periodic tasks using the process-wide flush service instead of a dedicated thread
+        void share(const Parameters &parameters)
+        {
+            flush_task_ = std::make_unique<intrometry::backend::FlushService::Task>(
+                    parameters.rate_,
+                    getMaxIdleSteps(parameters, clock_),
+                    [this, publish_statistics = parameters.statistics_](const std::size_t skipped_steps)
+                    {
+                        step(publish_statistics);
+                        intrometry::backend::increment(counters_.flush_overruns_, skipped_steps);
+                    });
+            if (not flush_task_->valid())
+            {
+                flush_task_.reset();
+                thread_supervisor_.log("Incorrect spin rate");
+                return;
+            }
+
+            flush_service_ = intrometry::backend::FlushService::get(parameters.shared_threads_, parameters.thread_);
+            const std::string thread_errors = flush_service_->getThreadErrors();
+            if (not thread_errors.empty())
+            {
+                intrometry::backend::increment(counters_.thread_errors_);
+                thread_supervisor_.log("Could not apply thread parameters: ", thread_errors);
+            }
+            flush_service_->add(*flush_task_);
+        }
+
+
+        void step(const bool publish_statistics)
+        {
+            flush();
+            if (executor_)
+            {
+                executor_->spin_some();
+            }
+
+            // statistics are published and the clock is re-anchored once per second
+            if (std::chrono::steady_clock::now() >= second_deadline_)
+            {
+                second_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                clock_.anchor();
+                counters_.sampleThread();
+                if (publish_statistics)
+                {
+                    getStatistics(statistics_);
+                    write(statistics_handle_, statistics_, 0);
+                }
+            }
+        }
+
+
+        void notify()
+        {
+            if (flush_task_)
+            {
+                flush_task_->notify();
+            }
+            else
+            {
+                timer_.notify();
+            }
+        }
+
+
+        void updateSubscription()
+        {
+            if (values_publisher_->get_subscription_count() > 0
+                or values_publisher_->get_intra_process_subscription_count() > 0)
+            {
+                if (not subscribed_.exchange(true))
+                {
+                    subscription_generation_.fetch_add(1);
+                }
+            }
+            else
+            {
+                subscribed_ = false;
+            }
+        }
+
+
         void flush()
         {
-            sources_.tryFlush([this](WriterWrapper &writer)
-                              { writer.publish(names_publisher_, values_publisher_); });
+            intrometry::backend::increment(counters_.flush_ticks_);
+
+            updateSubscription();
+            if (subscribed_)
+            {
+                const uint32_t generation = subscription_generation_;
+                bool pending = false;
+                sources_.visit(
+                        [this, generation, &pending](WriterWrapper &writer)
+                        {
+                            if (not writer.publish(names_publisher_, values_publisher_, generation))
+                            {
+                                pending = true;
+                            }
+                        });
+                if (pending)
+                {
+                    // keep flushing, the sink thread would go idle otherwise
+                    notify();
+                }
+            }
+            else
+            {
+                // there is nobody to publish to, skip serialization
+                sources_.visit(
+                        [this](WriterWrapper &writer)
+                        {
+                            if (writer.discard())
+                            {
+                                intrometry::backend::increment(counters_.unsubscribed_);
+                            }
+                        });
+            }
+        }
+
+
+        /// @return false if the sample should be dropped without flattening
+        bool accept()
+        {
+            if (on_demand_ and not subscribed_.load(std::memory_order_relaxed))
+            {
+                intrometry::backend::increment(counters_.unsubscribed_);
+                // flushes are needed to detect subscribers
+                notify();
+                return (false);
+            }
+            return (true);
+        }
+
+
+        void write(const std::string &id, const ariles2::DefaultBase &source, const uint64_t timestamp)
+        {
+            if (not accept())
+            {
+                return;
+            }
+
+            switch (sources_.write(
+                    id,
+                    source,
+                    [this, &source, &timestamp](WriterWrapper &writer)
+                    {
+                        writer.write(source, timestamp, names_version_);
+                    }))
+            {
+                case intrometry::backend::SourceContainerBase::WriteStatus::ACCEPTED:
+                    notify();
+                    break;
+
+                case intrometry::backend::SourceContainerBase::WriteStatus::UNASSIGNED:
+                    intrometry::backend::increment(counters_.unassigned_);
+                    thread_supervisor_.log(
+                            "Measurement source handler is not assigned, skipping id: ", source.arilesDefaultID());
+                    break;
+            }
+        }
+
+
+        template <class t_Source>
+        void write(const SourceHandle &handle, const t_Source &source, const uint64_t timestamp)
+        {
+            if (not accept())
+            {
+                return;
+            }
+
+            const std::shared_ptr<WriterWrapper> writer = handle.lock<WriterWrapper>(this);
+            if (writer)
+            {
+                writer->write(source, timestamp, names_version_);
+                notify();
+            }
+            else
+            {
+                intrometry::backend::increment(counters_.unassigned_);
+            }
+        }
+
+
+        void getStatistics(SinkStatistics &statistics)
+        {
+            statistics.sources_.clear();
+            sources_.visit(
+                    [&statistics](const WriterWrapper &writer)
+                    {
+                        statistics.sources_.emplace_back();
+                        writer.getStatistics(statistics.sources_.back());
+                    });
+            counters_.get(statistics);
         }
     };
 }  // namespace intrometry::pjmsg_topic::sink
@@ -363,17 +883,23 @@ namespace intrometry::pjmsg_topic
         {
             return (false);
         }
-        make_pimpl(parameters_.id_, parameters_.rate_);
+        make_pimpl(parameters_);
         return (true);
     }
 
 
-    void Sink::assign(const std::string &id, const ariles2::DefaultBase &source, const Source::Parameters &parameters)
+    SourceHandle Sink::assign(
+            const std::string &id,
+            const ariles2::DefaultBase &source,
+            const Source::Parameters &parameters)
     {
         if (pimpl_)
         {
-            pimpl_->sources_.tryEmplace(id, source, parameters.persistent_structure_, pimpl_->names_version_);
+            return (SourceHandle(
+                    pimpl_.get(),
+                    pimpl_->sources_.tryEmplace(id, source, parameters, pimpl_->names_version_, pimpl_->clock_)));
         }
+        return (SourceHandle());
     }
 
 
@@ -390,21 +916,25 @@ namespace intrometry::pjmsg_topic
     {
         if (pimpl_)
         {
-            if (not pimpl_->sources_.tryWrite(
-                        id,
-                        source,
-                        [this, &source, &timestamp](WriterWrapper &writer)
-                        {
-                            writer.write(
-                                    source,
-                                    (0 == timestamp) ? pimpl_->node_->now() :
-                                                       rclcpp::Time(static_cast<rcl_time_point_value_t>(timestamp)),
-                                    pimpl_->names_version_);
-                        }))
-            {
-                pimpl_->thread_supervisor_.log(
-                        "Measurement source handler is not assigned, skipping id: ", source.arilesDefaultID());
-            }
+            pimpl_->write(id, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const ariles2::DefaultBase &source, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, source, timestamp);
+        }
+    }
+
+
+    void Sink::write(const SourceHandle &handle, const Sample &sample, const uint64_t timestamp)
+    {
+        if (pimpl_)
+        {
+            pimpl_->write(handle, sample, timestamp);
         }
     }
 
@@ -416,4 +946,15 @@ namespace intrometry::pjmsg_topic
             pimpl_->flush();
         }
     }
+
+
+    SinkStatistics Sink::statistics() const
+    {
+        SinkStatistics result;
+        if (pimpl_)
+        {
+            pimpl_->getStatistics(result);
+        }
+        return (result);
+    }
 }  // namespace intrometry::pjmsg_topic
@@ -0,0 +1,210 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <ariles2/adapters/std_vector.h>
+
+#include <intrometry/pjmsg_mcap/all.h>
+#include <intrometry/pjmsg_topic/all.h>
+
+
+namespace intrometry_benchmark
+{
+    /// fixed number of scalar entries
+    class Scalars : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "Scalars"
+#define ARILES2_ENTRIES(v)                                                                                             \
+    ARILES2_TYPED_ENTRY_(v, s0, double)                                                                                \
+    ARILES2_TYPED_ENTRY_(v, s1, double)                                                                                \
+    ARILES2_TYPED_ENTRY_(v, s2, double)                                                                                \
+    ARILES2_TYPED_ENTRY_(v, s3, double)                                                                                \
+    ARILES2_TYPED_ENTRY_(v, s4, double)                                                                                \
+    ARILES2_TYPED_ENTRY_(v, s5, std::size_t)                                                                           \
+    ARILES2_TYPED_ENTRY_(v, s6, std::size_t)                                                                           \
+    ARILES2_TYPED_ENTRY_(v, s7, std::size_t)                                                                           \
+    ARILES2_TYPED_ENTRY_(v, s8, float)                                                                                 \
+    ARILES2_TYPED_ENTRY_(v, s9, float)
+#include ARILES2_INITIALIZE
+    };
+
+
+    class Vector : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "Vector"
+#define ARILES2_ENTRIES(v) ARILES2_TYPED_ENTRY_(v, vec, std::vector<float>)
+#include ARILES2_INITIALIZE
+
+    public:
+        void resize(const std::size_t size)
+        {
+            vec_.resize(size, 1.0);
+        }
+    };
+
+
+    class Element : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "Element"
+#define ARILES2_ENTRIES(v)                                                                                             \
+    ARILES2_TYPED_ENTRY_(v, duration, double)                                                                          \
+    ARILES2_TYPED_ENTRY_(v, size, std::size_t)                                                                         \
+    ARILES2_TYPED_ENTRY_(v, vec, std::vector<float>)
+#include ARILES2_INITIALIZE
+    };
+
+
+    /// nested container, 5 entries per element
+    class Nested : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "Nested"
+#define ARILES2_ENTRIES(v) ARILES2_TYPED_ENTRY_(v, entries, std::vector<Element>)
+#include ARILES2_INITIALIZE
+
+    public:
+        void resize(const std::size_t size)
+        {
+            entries_.resize(std::max<std::size_t>(1, size / 5));
+            for (Element &element : entries_)
+            {
+                element.duration_ = 1.0;
+                element.size_ = 1;
+                element.vec_.resize(3, 1.0);
+            }
+        }
+    };
+
+
+    class McapBackend
+    {
+    public:
+        using Sink = intrometry::pjmsg_mcap::Sink;
+
+    protected:
+        /// Output directory of the process, removed at exit after static sinks that are created later
+        class Directory
+        {
+        public:
+            const std::filesystem::path path_;  // NOLINT
+
+        public:
+            Directory()
+              : path_(std::filesystem::temp_directory_path() / "intrometry_benchmark" / std::to_string(getpid()))
+            {
+            }
+
+            ~Directory()
+            {
+                std::error_code error_code;
+                std::filesystem::remove_all(path_, error_code);
+                // removed only if empty, i.e., not used by other processes
+                std::filesystem::remove(path_.parent_path(), error_code);
+            }
+
+            Directory(const Directory &) = delete;
+            Directory &operator=(const Directory &) = delete;
+        };
+
+    public:
+        static intrometry::pjmsg_mcap::sink::Parameters parameters(const std::string &id)
+        {
+            static const Directory directory;
+            return (intrometry::pjmsg_mcap::sink::Parameters(id).directory(directory.path_));
+        }
+    };
+
+
+    class TopicBackend
+    {
+    public:
+        using Sink = intrometry::pjmsg_topic::Sink;
+
+    public:
+        static intrometry::pjmsg_topic::sink::Parameters parameters(const std::string &id)
+        {
+            return (intrometry::pjmsg_topic::sink::Parameters(id));
+        }
+    };
+
+
+    /**
+     * One sink per backend shared by all benchmarks and threads.
+     * @return nullptr if initialization failed, the benchmark is skipped
+     */
+    template <class t_Backend>
+    intrometry::Sink *getSink(benchmark::State &state)
+    {
+        static typename t_Backend::Sink sink(t_Backend::parameters("benchmark"));
+        static const bool initialized = sink.initialize();
+        if (not initialized)
+        {
+            state.SkipWithError("Sink initialization failed");
+            return (nullptr);
+        }
+        return (&sink);
+    }
+
+
+    /// Per-thread latency samples
+    class Latency
+    {
+    protected:
+        static constexpr std::size_t max_samples_ = 1000000;
+        std::vector<double> samples_;
+        std::chrono::time_point<std::chrono::steady_clock> start_;
+
+    public:
+        explicit Latency(const benchmark::State &state)
+        {
+            samples_.reserve(std::min<std::size_t>(state.max_iterations, max_samples_));
+        }
+
+        void start()
+        {
+            start_ = std::chrono::steady_clock::now();
+        }
+
+        void stop()
+        {
+            const std::chrono::time_point<std::chrono::steady_clock> stop = std::chrono::steady_clock::now();
+            if (samples_.size() < max_samples_)
+            {
+                samples_.push_back(std::chrono::duration<double, std::nano>(stop - start_).count());
+            }
+        }
+
+        /// latency percentiles are averaged over threads
+        void report(benchmark::State &state)
+        {
+            if (samples_.empty())
+            {
+                return;
+            }
+            std::sort(samples_.begin(), samples_.end());
+
+            const auto percentile = [this](const double value)
+            { return (samples_[static_cast<std::size_t>(value * static_cast<double>(samples_.size() - 1))]); };
+
+            state.counters["p50_ns"] = benchmark::Counter(percentile(0.5), benchmark::Counter::kAvgThreads);
+            state.counters["p99_ns"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+            state.counters["p99.9_ns"] = benchmark::Counter(percentile(0.999), benchmark::Counter::kAvgThreads);
+        }
+    };
+}  // namespace intrometry_benchmark
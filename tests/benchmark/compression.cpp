@@ -0,0 +1,126 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Throughput and compression ratio of pjmsg_mcap compression modes.
+*/
+
+#include <cmath>
+
+#include "common.h"
+
+
+namespace
+{
+    using namespace intrometry_benchmark;
+    using McapParameters = intrometry::pjmsg_mcap::sink::Parameters;
+
+
+    /// Joint states of a robot: smooth signals with a bit of noise
+    class Telemetry : public ariles2::DefaultBase
+    {
+#define ARILES2_DEFAULT_ID "Telemetry"
+#define ARILES2_ENTRIES(v)                                                                                             \
+    ARILES2_TYPED_ENTRY_(v, position, std::vector<double>)                                                             \
+    ARILES2_TYPED_ENTRY_(v, velocity, std::vector<double>)                                                             \
+    ARILES2_TYPED_ENTRY_(v, effort, std::vector<double>)                                                               \
+    ARILES2_TYPED_ENTRY_(v, temperature, std::vector<float>)                                                           \
+    ARILES2_TYPED_ENTRY_(v, mode, std::vector<std::size_t>)
+#include ARILES2_INITIALIZE
+
+    public:
+        explicit Telemetry(const std::size_t joints = 100)
+        {
+            position_.resize(joints);
+            velocity_.resize(joints);
+            effort_.resize(joints);
+            temperature_.resize(joints);
+            mode_.resize(joints, 2);
+        }
+
+        void update(const std::size_t step)
+        {
+            const double time = static_cast<double>(step) * 0.002;
+            for (std::size_t i = 0; i < position_.size(); ++i)
+            {
+                const double phase = time + static_cast<double>(i);
+                const double noise = static_cast<double>((step * 7919 + i * 104729) % 1000) * 1e-6;
+
+                position_[i] = std::sin(phase) + noise;
+                velocity_[i] = std::cos(phase) + noise;
+                effort_[i] = 10.0 * std::sin(2.0 * phase) + noise;
+                temperature_[i] = 40.0F + static_cast<float>(time * 0.01);
+            }
+        }
+    };
+
+
+    void compressionArguments(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({ "compression" });
+        for (const McapParameters::Compression compression :
+             { McapParameters::Compression::NONE, McapParameters::Compression::ZSTD })
+        {
+            benchmark->Args({ static_cast<int64_t>(compression) });
+        }
+        benchmark->UseRealTime();
+    }
+
+
+    void compression(benchmark::State &state)
+    {
+        const std::filesystem::path directory =
+                std::filesystem::temp_directory_path() / "intrometry_benchmark_compression" / std::to_string(getpid());
+        std::filesystem::remove_all(directory);
+
+        uint64_t raw_bytes = 0;
+        {
+            intrometry::pjmsg_mcap::Sink sink(
+                    McapParameters("compression")
+                            .directory(directory)
+                            .rate(1)
+                            .compression(static_cast<McapParameters::Compression>(state.range(0))));
+            if (not sink.initialize())
+            {
+                state.SkipWithError("Sink initialization failed");
+                return;
+            }
+
+            Telemetry telemetry;
+            const intrometry::SourceHandle handle =
+                    sink.assign(telemetry, intrometry::Source::Parameters(/*persistent_structure=*/true));
+
+            std::size_t step = 0;
+            for (auto _ : state)  // NOLINT
+            {
+                state.PauseTiming();
+                telemetry.update(step++);
+                sink.write(handle, telemetry);
+                state.ResumeTiming();
+
+                sink.flush();
+            }
+
+            raw_bytes = sink.statistics().total_.bytes_;
+        }
+
+        uint64_t file_bytes = 0;
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory))
+        {
+            file_bytes += entry.file_size();
+        }
+        std::filesystem::remove_all(directory);
+
+        state.counters["MB/s"] =
+                benchmark::Counter(static_cast<double>(raw_bytes) / 1e6, benchmark::Counter::kIsRate);
+        state.counters["ratio"] =
+                (file_bytes > 0) ? static_cast<double>(raw_bytes) / static_cast<double>(file_bytes) : 0.0;
+    }
+}  // namespace
+
+
+BENCHMARK(compression)->Apply(compressionArguments);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Latency of pjmsg_mcap flushing depending on the number of sources.
+*/
+
+#include "common.h"
+
+
+namespace
+{
+    using namespace intrometry_benchmark;
+
+
+    /// sources x compression
+    void flushArguments(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({ "sources", "zstd" });
+        for (const int64_t sources : { 100, 500 })
+        {
+            for (const int64_t zstd : { 0, 1 })
+            {
+                benchmark->Args({ sources, zstd });
+            }
+        }
+        benchmark->UseRealTime();
+    }
+
+
+    void flush(benchmark::State &state)
+    {
+        constexpr std::size_t source_size = 100;
+
+        // low rate: flushing is triggered explicitly
+        intrometry::pjmsg_mcap::sink::Parameters parameters = McapBackend::parameters("flush").rate(1);
+        if (state.range(1) > 0)
+        {
+            parameters.compression(intrometry::pjmsg_mcap::sink::Parameters::Compression::ZSTD);
+        }
+        intrometry::pjmsg_mcap::Sink sink(parameters);
+        if (not sink.initialize())
+        {
+            state.SkipWithError("Sink initialization failed");
+            return;
+        }
+
+        std::vector<Vector> sources(static_cast<std::size_t>(state.range(0)));
+        std::vector<intrometry::SourceHandle> handles;
+        handles.reserve(sources.size());
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            sources[i].resize(source_size);
+            handles.push_back(
+                    sink.assign("source_" + std::to_string(i), sources[i], intrometry::Source::Parameters(true)));
+        }
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            state.PauseTiming();
+            for (std::size_t i = 0; i < sources.size(); ++i)
+            {
+                sink.write(handles[i], sources[i]);
+            }
+            state.ResumeTiming();
+
+            latency.start();
+            sink.flush();
+            latency.stop();
+        }
+
+        latency.report(state);
+    }
+}  // namespace
+
+
+BENCHMARK(flush)->Apply(flushArguments);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,241 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief Write path latency benchmarks.
+*/
+
+#include "common.h"
+
+
+namespace
+{
+    using namespace intrometry_benchmark;
+
+
+    /// size x persistent structure x handle
+    void writeArguments(benchmark::internal::Benchmark *benchmark, const std::vector<int64_t> &sizes)
+    {
+        benchmark->ArgNames({ "size", "persistent", "handle" });
+        for (const int64_t size : sizes)
+        {
+            for (const int64_t persistent : { 0, 1 })
+            {
+                for (const int64_t handle : { 0, 1 })
+                {
+                    benchmark->Args({ size, persistent, handle });
+                }
+            }
+        }
+        benchmark->ThreadRange(1, 16);
+        benchmark->UseRealTime();
+    }
+
+    void writeArguments(benchmark::internal::Benchmark *benchmark)
+    {
+        writeArguments(benchmark, { 10, 100, 1000, 10000, 100000 });
+    }
+
+    /// Scalars have a fixed size
+    void scalarWriteArguments(benchmark::internal::Benchmark *benchmark)
+    {
+        writeArguments(benchmark, { 10 });
+    }
+
+
+    void sizeArguments(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({ "size" });
+        benchmark->RangeMultiplier(10)->Range(10, 100000);
+        benchmark->UseRealTime();
+    }
+
+
+    template <class t_Backend, class t_Source>
+    void sinkWrite(benchmark::State &state)
+    {
+        intrometry::Sink *const sink = getSink<t_Backend>(state);
+        if (nullptr == sink)
+        {
+            return;
+        }
+        const std::string id = "write_" + std::to_string(state.thread_index());
+        const intrometry::Source::Parameters parameters(state.range(1) > 0);
+        const bool use_handle = state.range(2) > 0;
+
+        t_Source source;
+        if constexpr (not std::is_same_v<t_Source, Scalars>)
+        {
+            source.resize(static_cast<std::size_t>(state.range(0)));
+        }
+        const intrometry::SourceHandle handle = sink->assign(id, source, parameters);
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            latency.start();
+            if (use_handle)
+            {
+                sink->write(handle, source);
+            }
+            else
+            {
+                sink->write(id, source);
+            }
+            latency.stop();
+        }
+
+        sink->retract(id, source);
+        latency.report(state);
+    }
+
+
+    /// write() copies the source, flattening is performed by the sink thread
+    template <class t_Backend, class t_Source>
+    void deferredWrite(benchmark::State &state)
+    {
+        intrometry::Sink *const sink = getSink<t_Backend>(state);
+        if (nullptr == sink)
+        {
+            return;
+        }
+        const std::string id = "deferred_" + std::to_string(state.thread_index());
+
+        t_Source source;
+        source.resize(static_cast<std::size_t>(state.range(0)));
+        const intrometry::SourceHandle handle =
+                sink->assign(id, source, intrometry::Source::Parameters(true).deferred<t_Source>());
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            latency.start();
+            sink->write(handle, source);
+            latency.stop();
+        }
+
+        sink->retract(id, source);
+        latency.report(state);
+    }
+
+
+    template <class t_Backend>
+    void comboWrite(benchmark::State &state)
+    {
+        intrometry::ComboSink<Scalars, Vector, Nested> combo;
+        const std::size_t size = static_cast<std::size_t>(state.range(0));
+        combo.get<Vector>().resize(size);
+        combo.get<Nested>().resize(size);
+
+        if (not combo.template initialize<typename t_Backend::Sink>(
+                    intrometry::Source::Parameters(true), t_Backend::parameters("combo")))
+        {
+            state.SkipWithError("Sink initialization failed");
+            return;
+        }
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            latency.start();
+            combo.write();
+            latency.stop();
+        }
+
+        latency.report(state);
+    }
+
+
+    template <class t_Backend, class t_Source>
+    void assignRetract(benchmark::State &state)
+    {
+        intrometry::Sink *const sink = getSink<t_Backend>(state);
+        if (nullptr == sink)
+        {
+            return;
+        }
+        const intrometry::Source::Parameters parameters(true);
+
+        t_Source source;
+        source.resize(static_cast<std::size_t>(state.range(0)));
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            latency.start();
+            (void)sink->assign("assign", source, parameters);
+            sink->retract("assign", source);
+            latency.stop();
+        }
+
+        latency.report(state);
+    }
+
+
+    template <class t_Backend, class t_Source>
+    void flush(benchmark::State &state)
+    {
+        // dedicated sink with low rate: flushing is triggered explicitly and
+        // is rarely preceded by a periodic flush of the same data
+        typename t_Backend::Sink sink(t_Backend::parameters("flush").rate(1));
+        if (not sink.initialize())
+        {
+            state.SkipWithError("Sink initialization failed");
+            return;
+        }
+        const intrometry::Source::Parameters parameters(true);
+
+        t_Source source;
+        source.resize(static_cast<std::size_t>(state.range(0)));
+        const intrometry::SourceHandle handle = sink.assign("flush", source, parameters);
+        Latency latency(state);
+
+        for (auto _ : state)  // NOLINT
+        {
+            state.PauseTiming();
+            sink.write(handle, source);
+            state.ResumeTiming();
+
+            latency.start();
+            sink.flush();
+            latency.stop();
+        }
+
+        sink.retract("flush", source);
+        latency.report(state);
+    }
+}  // namespace
+
+
+#define INTROMETRY_BENCHMARK_SOURCES(backend)                                                                          \
+    BENCHMARK_TEMPLATE(sinkWrite, backend, Scalars)->Apply(scalarWriteArguments);                                      \
+    BENCHMARK_TEMPLATE(sinkWrite, backend, Vector)->Apply(writeArguments);                                             \
+    BENCHMARK_TEMPLATE(sinkWrite, backend, Nested)->Apply(writeArguments);                                             \
+    BENCHMARK_TEMPLATE(comboWrite, backend)->Apply(sizeArguments);                                                     \
+    BENCHMARK_TEMPLATE(assignRetract, backend, Vector)->Apply(sizeArguments);                                          \
+    BENCHMARK_TEMPLATE(assignRetract, backend, Nested)->Apply(sizeArguments);                                          \
+    BENCHMARK_TEMPLATE(flush, backend, Vector)->Apply(sizeArguments);                                                  \
+    BENCHMARK_TEMPLATE(flush, backend, Nested)->Apply(sizeArguments);
+
+INTROMETRY_BENCHMARK_SOURCES(McapBackend)
+INTROMETRY_BENCHMARK_SOURCES(TopicBackend)
+
+// deferred mode is supported by mcap backend only
+BENCHMARK_TEMPLATE(deferredWrite, McapBackend, Vector)->Apply(sizeArguments)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(deferredWrite, McapBackend, Nested)->Apply(sizeArguments)->ThreadRange(1, 16);
+
+
+int main(int argc, char **argv)
+{
+    rclcpp::init(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return (1);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    rclcpp::shutdown();
+    return (0);
+}
@@ -88,6 +88,60 @@ TEST_F(PjmsgMcapMultiSinkFixture, Multi)
     ASSERT_TRUE(true);
 }
 
+TEST_F(PjmsgMcapMultiSinkFixture, Deferred)
+{
+    MultiPub pub;
+    // deferred mode is enabled for each source with its own type
+    ASSERT_TRUE(pub.initialize<intrometry::pjmsg_mcap::Sink>(
+            intrometry::Source::Parameters(/*persistent_structure=*/true).deferred<intrometry_tests::ArilesDebug>(),
+            "deferred"));
+
+    for (std::size_t i = 0; i < 5; ++i)
+    {
+        pub.get<intrometry_tests::ArilesDebug>().size_ = i;
+        pub.get<intrometry_tests::ArilesDebug1>().size_ = i * 10;
+        pub.write();
+        pub.flush();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    ASSERT_EQ(10, pub.sink_->statistics().total_.accepted_);
+}
+
+
+TEST_F(PjmsgMcapMultiSinkFixture, Combined)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_combined";
+    const std::string sink_id = "combined";
+    std::filesystem::remove_all(directory);
+
+    constexpr std::size_t num_samples = 5;
+    {
+        MultiPub pub;
+        ASSERT_TRUE(pub.initialize<intrometry::pjmsg_mcap::Sink>(
+                intrometry::Source::Parameters(/*persistent_structure=*/true),
+                intrometry::pjmsg_mcap::sink::Parameters(sink_id).directory(directory)));
+
+        for (std::size_t i = 0; i < num_samples; ++i)
+        {
+            pub.get<intrometry_tests::ArilesDebug>().size_ = i;
+            pub.get<intrometry_tests::ArilesDebug1>().size_ = i * 10;
+            pub.write();
+            pub.flush();
+        }
+
+        // all sources are written as one
+        const intrometry::SinkStatistics statistics = pub.sink_->statistics();
+        ASSERT_EQ(1, statistics.sources_.size());
+        ASSERT_EQ(num_samples, statistics.total_.accepted_);
+    }
+
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(directory, sink_id));
+
+    std::filesystem::remove_all(directory);
+}
+
 
 int main(int argc, char **argv)
 {
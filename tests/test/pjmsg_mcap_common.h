@@ -17,6 +17,31 @@
 
 namespace intrometry_tests
 {
+    inline std::size_t countMcap(const std::filesystem::path &directory, const std::string &sink_id)
+    {
+        std::size_t counter = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(directory))
+        {
+            if (entry.path().extension() != ".mcap")
+            {
+                continue;
+            }
+            if (entry.path().filename().string().find(sink_id) == std::string::npos)
+            {
+                continue;
+            }
+            pjmsg_mcap_wrapper::Reader reader;
+            reader.initialize(entry.path(), std::string("/intrometry/") + sink_id);
+            pjmsg_mcap_wrapper::Message message;
+            while (reader.next(message))
+            {
+                ++counter;
+            }
+        }
+        return (counter);
+    }
+
+
     inline bool checkMcap(const std::filesystem::path &directory, const std::string &sink_id)
     {
         bool found_messages = false;
@@ -44,6 +69,13 @@ namespace intrometry_tests
                 {
                     return (false);
                 }
+                for (const std::string &name : message.names())
+                {
+                    if (name.empty())
+                    {
+                        return (false);
+                    }
+                }
             }
         }
         return (found_messages);
@@ -8,8 +8,14 @@
 
 #include "pjmsg_mcap_common.h"
 
+#include <intrometry/tee/sink.h>
+
+#include <csignal>
+#include <limits>
 #include <memory>
 
+#include <sched.h>
+
 
 namespace
 {
@@ -61,6 +67,78 @@ namespace
         }
     };
 
+    class PjmsgMcapIOThread
+    {
+    public:
+        std::filesystem::path directory_;
+        std::unique_ptr<intrometry::pjmsg_mcap::Sink> intrometry_sink_;
+        static constexpr const char *sink_id_ = "intrometryfixtureiothread";
+
+    public:
+        PjmsgMcapIOThread() : directory_(std::filesystem::temp_directory_path() / "intrometry_mcap_io_thread")
+        {
+            std::filesystem::remove_all(directory_);
+            intrometry_sink_ = std::make_unique<intrometry::pjmsg_mcap::Sink>(
+                    intrometry::pjmsg_mcap::sink::Parameters("IntrometryFixtureIOThread")
+                            .directory(directory_)
+                            .io_queue_size(64));
+            intrometry_sink_->initialize();
+        }
+
+        ~PjmsgMcapIOThread()
+        {
+            std::filesystem::remove_all(directory_);
+        }
+    };
+
+    class PjmsgMcapTSC
+    {
+    public:
+        std::filesystem::path directory_;
+        std::unique_ptr<intrometry::pjmsg_mcap::Sink> intrometry_sink_;
+        static constexpr const char *sink_id_ = "intrometryfixturetsc";
+
+    public:
+        PjmsgMcapTSC() : directory_(std::filesystem::temp_directory_path() / "intrometry_mcap_tsc")
+        {
+            std::filesystem::remove_all(directory_);
+            intrometry_sink_ = std::make_unique<intrometry::pjmsg_mcap::Sink>(
+                    intrometry::pjmsg_mcap::sink::Parameters("IntrometryFixtureTSC")
+                            .directory(directory_)
+                            .clock(intrometry::Clock(intrometry::Clock::Type::TSC)));
+            intrometry_sink_->initialize();
+        }
+
+        ~PjmsgMcapTSC()
+        {
+            std::filesystem::remove_all(directory_);
+        }
+    };
+
+    class PjmsgMcapShared
+    {
+    public:
+        std::filesystem::path directory_;
+        std::unique_ptr<intrometry::pjmsg_mcap::Sink> intrometry_sink_;
+        static constexpr const char *sink_id_ = "intrometryfixtureshared";
+
+    public:
+        PjmsgMcapShared() : directory_(std::filesystem::temp_directory_path() / "intrometry_mcap_shared")
+        {
+            std::filesystem::remove_all(directory_);
+            intrometry_sink_ = std::make_unique<intrometry::pjmsg_mcap::Sink>(
+                    intrometry::pjmsg_mcap::sink::Parameters("IntrometryFixtureShared")
+                            .directory(directory_)
+                            .shared_threads(2));
+            intrometry_sink_->initialize();
+        }
+
+        ~PjmsgMcapShared()
+        {
+            std::filesystem::remove_all(directory_);
+        }
+    };
+
     template <class t_Base>
     class PjmsgMcapIntrometryFixture : public ::testing::Test, public t_Base
     {
@@ -68,7 +146,12 @@ namespace
         using t_Base::t_Base;
     };
 
-    using PjmsgMcapIntrometryFixtureTypes = ::testing::Types<PjmsgMcapRaw, PjmsgMcapCompressed>;
+    using PjmsgMcapIntrometryFixtureTypes = ::testing::Types<
+            PjmsgMcapRaw,
+            PjmsgMcapCompressed,
+            PjmsgMcapIOThread,
+            PjmsgMcapTSC,
+            PjmsgMcapShared>;
     class NameGenerator
     {
     public:
@@ -83,6 +166,18 @@ namespace
             {
                 return "PjmsgMcapCompressed";
             }
+            if constexpr (std::is_same_v<T, PjmsgMcapIOThread>)
+            {
+                return "PjmsgMcapIOThread";
+            }
+            if constexpr (std::is_same_v<T, PjmsgMcapTSC>)
+            {
+                return "PjmsgMcapTSC";
+            }
+            if constexpr (std::is_same_v<T, PjmsgMcapShared>)
+            {
+                return "PjmsgMcapShared";
+            }
         }
     };
     TYPED_TEST_SUITE(PjmsgMcapIntrometryFixture, PjmsgMcapIntrometryFixtureTypes, NameGenerator);
@@ -218,6 +313,84 @@ TYPED_TEST(PjmsgMcapIntrometryFixture, ContainerShrinking)
 }
 
 
+TYPED_TEST(PjmsgMcapIntrometryFixture, Lossless)
+{
+    intrometry_tests::ArilesDebug debug{};
+    this->intrometry_sink_->assign(
+            debug, intrometry::Source::Parameters(/*persistent_structure=*/true).buffer_size(100));
+
+    constexpr std::size_t num_samples = 50;
+    for (debug.size_ = 0; debug.size_ < num_samples; ++debug.size_)
+    {
+        this->intrometry_sink_->write(debug);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    this->intrometry_sink_->retract(debug);
+    this->intrometry_sink_ = nullptr;
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(this->directory_, this->sink_id_)));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(this->directory_, this->sink_id_));
+}
+
+
+TYPED_TEST(PjmsgMcapIntrometryFixture, Deferred)
+{
+    intrometry_tests::ArilesDebugContainer container{};
+    container.entries_.resize(3);
+    const intrometry::SourceHandle handle = this->intrometry_sink_->assign(
+            container,
+            intrometry::Source::Parameters(/*persistent_structure=*/true)
+                    .deferred<intrometry_tests::ArilesDebugContainer>());
+
+    constexpr std::size_t num_samples = 5;
+    for (std::size_t i = 0; i < num_samples; ++i)
+    {
+        container.entries_.at(i % container.entries_.size()).size_ = i;
+        this->intrometry_sink_->write(container);
+        this->intrometry_sink_->flush();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    ASSERT_EQ(num_samples, this->intrometry_sink_->statistics().total_.accepted_);
+
+    // sources of other types are not copied to deferred sources
+    const intrometry_tests::ArilesDebug debug{};
+    this->intrometry_sink_->write(handle, debug);
+    ASSERT_EQ(num_samples, this->intrometry_sink_->statistics().total_.accepted_);
+    ASSERT_EQ(1, this->intrometry_sink_->statistics().unassigned_);
+
+    this->intrometry_sink_->retract(container);
+    this->intrometry_sink_ = nullptr;
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(this->directory_, this->sink_id_)));
+}
+
+
+TYPED_TEST(PjmsgMcapIntrometryFixture, Statistics)
+{
+    intrometry_tests::ArilesDebug debug{};
+    this->intrometry_sink_->assign(
+            debug, intrometry::Source::Parameters(/*persistent_structure=*/true).buffer_size(2));
+
+    constexpr std::size_t num_samples = 5;
+    for (debug.size_ = 0; debug.size_ < num_samples; ++debug.size_)
+    {
+        this->intrometry_sink_->write(debug);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    const intrometry::SinkStatistics statistics = this->intrometry_sink_->statistics();
+    ASSERT_EQ(1, statistics.sources_.size());
+    ASSERT_EQ("ArilesDebug", statistics.sources_[0].id_);
+    ASSERT_EQ(num_samples, statistics.total_.accepted_ + statistics.total_.dropped_full_);
+    ASSERT_EQ(statistics.total_.accepted_, statistics.total_.flushed_);
+    ASSERT_LT(0, statistics.total_.bytes_);
+    ASSERT_LT(0, statistics.flush_ticks_);
+
+    this->intrometry_sink_->retract(debug);
+}
+
+
 TYPED_TEST(PjmsgMcapIntrometryFixture, Flush)
 {
     const intrometry_tests::ArilesDebug debug{};
@@ -233,6 +406,315 @@ TYPED_TEST(PjmsgMcapIntrometryFixture, Flush)
 }
 
 
+TEST(PjmsgMcapIntrometry, Idle)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_idle";
+    const std::string sink_id = "intrometryidle";
+    std::filesystem::remove_all(directory);
+
+    {
+        intrometry::pjmsg_mcap::Sink sink(
+                intrometry::pjmsg_mcap::sink::Parameters("IntrometryIdle").directory(directory).rate(100));
+        sink.initialize();
+
+        intrometry_tests::ArilesDebug debug{};
+        sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+        sink.write(debug);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // no flushes without writes
+        const intrometry::SinkStatistics idle_statistics = sink.statistics();
+        ASSERT_EQ(1, idle_statistics.total_.flushed_);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        ASSERT_EQ(idle_statistics.flush_ticks_, sink.statistics().flush_ticks_);
+
+        // the first write wakes up the sink
+        sink.write(debug);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ASSERT_EQ(2, sink.statistics().total_.flushed_);
+    }
+
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    ASSERT_EQ(2, intrometry_tests::countMcap(directory, sink_id));
+
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(PjmsgMcapIntrometry, Thread)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_thread";
+    std::filesystem::remove_all(directory);
+
+    {
+        intrometry::pjmsg_mcap::Sink sink(
+                intrometry::pjmsg_mcap::sink::Parameters("IntrometryThread")
+                        .directory(directory)
+                        .thread(intrometry::ThreadParameters()
+                                        .policy(intrometry::ThreadParameters::Policy::BATCH)
+                                        .nice(1)
+                                        .name("intrometry")));
+        sink.initialize();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        const intrometry::SinkStatistics statistics = sink.statistics();
+        ASSERT_EQ(0, statistics.thread_errors_);
+        ASSERT_EQ(SCHED_BATCH, statistics.thread_policy_);
+        ASSERT_EQ(1, statistics.thread_nice_);
+        ASSERT_LE(0, statistics.thread_cpu_);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(PjmsgMcapIntrometry, Rotation)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_rotation";
+    const std::string sink_id = "intrometryrotation";
+    std::filesystem::remove_all(directory);
+
+    constexpr std::size_t num_samples = 40;
+    {
+        // every flush exceeds the size limit
+        intrometry::pjmsg_mcap::Sink sink(intrometry::pjmsg_mcap::sink::Parameters("IntrometryRotation")
+                                                  .directory(directory)
+                                                  .rate(50)
+                                                  .max_file_size(1));
+        sink.initialize();
+
+        intrometry_tests::ArilesDebug debug{};
+        sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true).buffer_size(num_samples));
+        for (debug.size_ = 0; debug.size_ < num_samples; ++debug.size_)
+        {
+            sink.write(debug);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    const std::size_t num_files = std::distance(
+            std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator());
+    ASSERT_LT(1, num_files);
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(directory, sink_id));
+
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(PjmsgMcapIntrometry, RotationRetention)
+{
+    const std::filesystem::path directory =
+            std::filesystem::temp_directory_path() / "intrometry_mcap_rotation_retention";
+    std::filesystem::remove_all(directory);
+
+    {
+        intrometry::pjmsg_mcap::Sink sink(intrometry::pjmsg_mcap::sink::Parameters("IntrometryRotationRetention")
+                                                  .directory(directory)
+                                                  .rate(50)
+                                                  .max_file_size(1)
+                                                  .max_files(2));
+        sink.initialize();
+
+        intrometry_tests::ArilesDebug debug{};
+        sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+        for (debug.size_ = 0; debug.size_ < 40; ++debug.size_)
+        {
+            sink.write(debug);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    const std::size_t num_files = std::distance(
+            std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator());
+    ASSERT_GE(2, num_files);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PjmsgMcapIntrometry, Aggregate)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_aggregate";
+    const std::string sink_id = "intrometryaggregate";
+    std::filesystem::remove_all(directory);
+
+    constexpr std::size_t num_samples = 20;
+    {
+        intrometry::pjmsg_mcap::Sink sink(
+                intrometry::pjmsg_mcap::sink::Parameters(sink_id).directory(directory).rate(10));
+        sink.initialize();
+
+        intrometry_tests::ArilesDebug debug{};
+        sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true).aggregate(true));
+        // all samples are written between two flushes
+        for (debug.size_ = 1; debug.size_ <= num_samples; ++debug.size_)
+        {
+            sink.write(debug);
+        }
+        sink.flush();
+    }
+
+    // samples may be split between flushes
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    for (const auto &entry : std::filesystem::directory_iterator(directory))
+    {
+        pjmsg_mcap_wrapper::Reader reader;
+        reader.initialize(entry.path(), std::string("/intrometry/") + sink_id);
+        pjmsg_mcap_wrapper::Message message;
+        while (reader.next(message))
+        {
+            for (std::size_t i = 0; i < message.names().size(); ++i)
+            {
+                const std::string &name = message.names()[i];
+                if (name.size() > 8 and name.compare(name.size() - 8, 8, "size_min") == 0)
+                {
+                    min = std::min(min, message.values()[i]);
+                }
+                if (name.size() > 8 and name.compare(name.size() - 8, 8, "size_max") == 0)
+                {
+                    max = std::max(max, message.values()[i]);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(1.0, min);
+    ASSERT_EQ(static_cast<double>(num_samples), max);
+
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(PjmsgMcapIntrometry, History)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_history";
+    const std::string sink_id = "intrometryhistory";
+    std::filesystem::remove_all(directory);
+
+    constexpr std::size_t rate = 20;
+    {
+        intrometry::pjmsg_mcap::Sink sink(intrometry::pjmsg_mcap::sink::Parameters(sink_id)
+                                                  .directory(directory)
+                                                  .rate(rate)
+                                                  .history_duration(std::chrono::seconds(1))
+                                                  .snapshot_signals({ SIGUSR1 }));
+        sink.initialize();
+
+        intrometry_tests::ArilesDebug debug{};
+        sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+        for (debug.size_ = 0; debug.size_ < 3 * rate; ++debug.size_)
+        {
+            sink.write(debug);
+            sink.flush();
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        // nothing is written without snapshots
+        ASSERT_EQ(0, intrometry_tests::countMcap(directory, sink_id));
+
+        ASSERT_TRUE(sink.snapshot());
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ASSERT_EQ(rate, intrometry_tests::countMcap(directory, sink_id));
+
+        ASSERT_EQ(0, raise(SIGUSR1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ASSERT_EQ(2 * rate, intrometry_tests::countMcap(directory, sink_id));
+    }
+
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(PjmsgMcapIntrometry, Tee)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_tee";
+    const std::filesystem::path directory_copy = std::filesystem::temp_directory_path() / "intrometry_mcap_tee_copy";
+    const std::string sink_id = "intrometrytee";
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove_all(directory_copy);
+
+    constexpr std::size_t num_samples = 10;
+    {
+        intrometry::tee::Sink sink(
+                intrometry::tee::sink::Parameters()
+                        .sink(std::make_shared<intrometry::pjmsg_mcap::Sink>(
+                                intrometry::pjmsg_mcap::sink::Parameters("IntrometryTee").directory(directory)))
+                        .sink(std::make_shared<intrometry::pjmsg_mcap::Sink>(
+                                intrometry::pjmsg_mcap::sink::Parameters("IntrometryTee").directory(directory_copy))));
+        ASSERT_TRUE(sink.initialize());
+
+        intrometry_tests::ArilesDebug debug{};
+        const intrometry::SourceHandle handle =
+                sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+        ASSERT_TRUE(handle.valid());
+        for (debug.size_ = 0; debug.size_ < num_samples; ++debug.size_)
+        {
+            sink.write(handle, debug);
+            sink.flush();
+        }
+
+        const intrometry::SinkStatistics statistics = sink.statistics();
+        ASSERT_EQ(2, statistics.sources_.size());
+        ASSERT_EQ(2 * num_samples, statistics.total_.accepted_);
+
+        sink.retract(debug);
+        ASSERT_FALSE(handle.valid());
+    }
+
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory_copy, sink_id)));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(directory, sink_id));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(directory_copy, sink_id));
+
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove_all(directory_copy);
+}
+
+
+TEST(PjmsgMcapIntrometry, TeeAsynchronous)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "intrometry_mcap_tee_async";
+    const std::string sink_id = "intrometryteeasync";
+    std::filesystem::remove_all(directory);
+
+    constexpr std::size_t num_samples = 10;
+    {
+        intrometry::tee::Sink sink(
+                intrometry::tee::sink::Parameters()
+                        .sink(std::make_shared<intrometry::pjmsg_mcap::Sink>(
+                                intrometry::pjmsg_mcap::sink::Parameters("IntrometryTeeAsync").directory(directory)))
+                        .asynchronous(true));
+        ASSERT_TRUE(sink.initialize());
+
+        intrometry_tests::ArilesDebug debug{};
+        const intrometry::SourceHandle handle =
+                sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+        ASSERT_TRUE(handle.valid());
+
+        while (not sink.ready())
+        {
+            ASSERT_FALSE(sink.failed());
+            // writes are ignored until the assignment is completed
+            sink.write(handle, debug);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        for (debug.size_ = 0; debug.size_ < num_samples; ++debug.size_)
+        {
+            sink.write(handle, debug);
+            sink.flush();
+        }
+        ASSERT_EQ(num_samples, sink.statistics().total_.accepted_);
+    }
+
+    ASSERT_NO_THROW(ASSERT_TRUE(intrometry_tests::checkMcap(directory, sink_id)));
+    ASSERT_EQ(num_samples, intrometry_tests::countMcap(directory, sink_id));
+
+    std::filesystem::remove_all(directory);
+}
+
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
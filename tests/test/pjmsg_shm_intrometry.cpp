@@ -0,0 +1,159 @@
+/**
+    @file
+    @author  Alexander Sherikov
+    @copyright 2025 Alexander Sherikov. Licensed under the Apache License,
+    Version 2.0. (see LICENSE or http://www.apache.org/licenses/LICENSE-2.0)
+    @brief
+*/
+
+#include <map>
+
+#include <intrometry/pjmsg_shm/all.h>
+#include <intrometry/pjmsg_shm/reader.h>
+
+#include "common.h"
+
+
+namespace
+{
+    class PjmsgShmIntrometryFixture : public ::testing::Test
+    {
+    public:
+        intrometry::pjmsg_shm::Sink intrometry_sink_;
+        intrometry::pjmsg_shm::Reader reader_;
+
+    public:
+        PjmsgShmIntrometryFixture() : intrometry_sink_(intrometry::pjmsg_shm::sink::Parameters("ShmIntrometryFixture"))
+        {
+        }
+
+        void SetUp() override
+        {
+            ASSERT_TRUE(intrometry_sink_.initialize());
+            ASSERT_TRUE(reader_.initialize("ShmIntrometryFixture"));
+        }
+
+        /// @return number of received samples, checks that names precede values
+        std::size_t read(std::size_t &names_received)
+        {
+            std::map<uint32_t, std::size_t> sizes;
+            intrometry::pjmsg_shm::Reader::Sample sample;
+            std::size_t samples = 0;
+
+            names_received = 0;
+            while (reader_.next(sample))
+            {
+                if (not sample.names_.empty())
+                {
+                    EXPECT_EQ(sample.names_.size(), sample.values_.size());
+                    sizes[sample.source_] = sample.names_.size();
+                    ++names_received;
+                }
+                EXPECT_EQ(sizes.at(sample.source_), sample.values_.size());
+                ++samples;
+            }
+            return (samples);
+        }
+    };
+}  // namespace
+
+
+TEST_F(PjmsgShmIntrometryFixture, ArilesDynamic)
+{
+    intrometry_tests::ArilesDebug debug;
+    const intrometry::SourceHandle handle = intrometry_sink_.assign(debug);
+
+    for (debug.size_ = 0; debug.size_ < 5; ++debug.size_)
+    {
+        debug.vec_.resize(debug.size_);
+        intrometry_sink_.write(handle, debug);
+        intrometry_sink_.flush();
+    }
+
+    std::size_t names_received = 0;
+    EXPECT_EQ(5, read(names_received));
+    // structure changes with each sample
+    EXPECT_EQ(5, names_received);
+    EXPECT_TRUE(reader_.alive());
+    EXPECT_EQ(0, reader_.dropped());
+}
+
+
+TEST_F(PjmsgShmIntrometryFixture, ArilesPersistent)
+{
+    intrometry_tests::ArilesDebug debug0{};
+    intrometry_tests::ArilesDebug1 debug1{};
+    debug0.vec_ = { 3.4, 2.2, 2.1 };
+    intrometry_sink_.assignBatch(intrometry::Source::Parameters(/*persistent_structure=*/true), debug0, debug1);
+
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        intrometry_sink_.writeBatch(0, debug0, debug1);
+        intrometry_sink_.flush();
+    }
+
+    std::size_t names_received = 0;
+    EXPECT_EQ(20, read(names_received));
+    // names are sent once per source
+    EXPECT_EQ(2, names_received);
+}
+
+
+TEST_F(PjmsgShmIntrometryFixture, Overflow)
+{
+    intrometry::pjmsg_shm::Sink sink(intrometry::pjmsg_shm::sink::Parameters("ShmOverflow").size(4096));
+    ASSERT_TRUE(sink.initialize());
+    intrometry::pjmsg_shm::Reader reader;
+    ASSERT_TRUE(reader.initialize("ShmOverflow"));
+
+    intrometry_tests::ArilesDebug debug{};
+    debug.vec_.resize(64);
+    const intrometry::SourceHandle handle = sink.assign(debug);
+
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        sink.write(handle, debug);
+        sink.flush();
+    }
+
+    EXPECT_LT(0, reader.dropped());
+    EXPECT_LT(0, sink.statistics().io_stalls_);
+
+    // writing resumes after the ring is drained
+    intrometry::pjmsg_shm::Reader::Sample sample;
+    ASSERT_TRUE(reader.next(sample));
+    EXPECT_FALSE(sample.names_.empty());
+    const std::size_t size = sample.values_.size();
+    while (reader.next(sample))
+    {
+        EXPECT_EQ(size, sample.values_.size());
+    }
+    sink.write(handle, debug);
+    sink.flush();
+    ASSERT_TRUE(reader.next(sample));
+    EXPECT_EQ(size, sample.values_.size());
+}
+
+
+TEST(PjmsgShmIntrometry, Lifetime)
+{
+    intrometry::pjmsg_shm::Reader reader;
+    EXPECT_FALSE(reader.initialize("ShmLifetime"));
+    {
+        intrometry::pjmsg_shm::Sink sink("ShmLifetime");
+        ASSERT_TRUE(sink.initialize());
+        ASSERT_TRUE(reader.initialize("ShmLifetime"));
+        EXPECT_TRUE(reader.alive());
+    }
+    EXPECT_FALSE(reader.alive());
+
+    intrometry::pjmsg_shm::Sink sink("");
+    EXPECT_FALSE(sink.initialize());
+}
+
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -161,6 +161,71 @@ TEST_F(PjmsgTopicIntrometryFixture, ContainerShrinking)
 }
 
 
+TEST(PjmsgTopicIntrometry, OnDemand)
+{
+    intrometry::pjmsg_topic::Sink sink(intrometry::pjmsg_topic::sink::Parameters("IntrometryOnDemand").on_demand(true));
+    ASSERT_TRUE(sink.initialize());
+
+    intrometry_tests::ArilesDebug debug{};
+    const intrometry::SourceHandle handle =
+            sink.assign(debug, intrometry::Source::Parameters(/*persistent_structure=*/true));
+
+    // nobody listens, samples are dropped by write()
+    for (debug.size_ = 0; debug.size_ < 5; ++debug.size_)
+    {
+        sink.write(handle, debug);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ASSERT_EQ(0, sink.statistics().total_.accepted_);
+    ASSERT_LT(0, sink.statistics().unsubscribed_);
+
+    // publishing resumes with names
+    intrometry_tests::SubscriberNode subscriber;
+    subscriber.initialize("intrometryondemand");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    for (debug.size_ = 0; debug.size_ < 5; ++debug.size_)
+    {
+        sink.write(handle, debug);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    ASSERT_TRUE(subscriber.checkReceived());
+}
+
+
+TEST(PjmsgTopicIntrometry, Node)
+{
+    intrometry_tests::SubscriberNode subscriber;
+    subscriber.initialize("intrometrynode");
+    intrometry_tests::SubscriberNode subscriber_shared;
+    subscriber_shared.initialize("intrometrysharednode");
+
+    // application node and process-wide node
+    intrometry::pjmsg_topic::Sink sink(intrometry::pjmsg_topic::sink::Parameters("IntrometryNode")
+                                               .node(std::make_shared<rclcpp::Node>("intrometry_tests_application")));
+    intrometry::pjmsg_topic::Sink sink_shared(
+            intrometry::pjmsg_topic::sink::Parameters("IntrometrySharedNode").shared_node(true));
+    ASSERT_TRUE(sink.initialize());
+    ASSERT_TRUE(sink_shared.initialize());
+
+    intrometry_tests::ArilesDebug debug{};
+    sink.assign(debug);
+    sink_shared.assign(debug);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    for (debug.size_ = 0; debug.size_ < 5; ++debug.size_)
+    {
+        sink.write(debug);
+        sink_shared.write(debug);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    ASSERT_TRUE(subscriber.checkReceived());
+    ASSERT_TRUE(subscriber_shared.checkReceived());
+}
+
+
 
 int main(int argc, char **argv)
 {
@@ -45,6 +45,30 @@ namespace
             sink_->retract(debug);
         }
 
+        void useSinkHandle()
+        {
+            intrometry_tests::ArilesDebug debug;
+            const intrometry::SourceHandle handle = sink_->assign(debug);
+            ASSERT_TRUE(handle.valid());
+
+            for (debug.size_ = 0; debug.size_ < 5; ++debug.size_)
+            {
+                sink_->write(handle, debug);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            sink_->retract(debug);
+            ASSERT_FALSE(handle.valid());
+
+            // ignored
+            sink_->write(handle, debug);
+
+            const intrometry::SinkStatistics statistics = sink_->statistics();
+            ASSERT_EQ(0, statistics.sources_.size());
+            ASSERT_EQ(1, statistics.unassigned_);
+        }
+
         void useSinkFlush()
         {
             intrometry_tests::ArilesDebug debug;
@@ -75,6 +99,20 @@ TEST_F(SinkBase, Topic)
     ASSERT_TRUE(true);
 }
 
+TEST_F(SinkBase, MCAPHandle)
+{
+    sink_ = sink_mcap_;
+    useSinkHandle();
+}
+
+TEST_F(SinkBase, TopicHandle)
+{
+    // ROS is not initialized in this test, the sink is disabled
+    sink_ = sink_topic_;
+    intrometry_tests::ArilesDebug debug;
+    ASSERT_FALSE(sink_->assign(debug).valid());
+}
+
 TEST_F(SinkBase, MCAPFlush)
 {
     sink_ = sink_mcap_;
@@ -89,6 +127,16 @@ TEST_F(SinkBase, TopicFlush)
     ASSERT_TRUE(true);
 }
 
+TEST(Sample, HashNames)
+{
+    ASSERT_EQ(intrometry::hashNames({ "a", "b" }), intrometry::hashNames({ "a", "b" }));
+    ASSERT_NE(intrometry::hashNames({ "a", "b" }), intrometry::hashNames({ "b", "a" }));
+    ASSERT_NE(intrometry::hashNames({ "ab", "c" }), intrometry::hashNames({ "a", "bc" }));
+    ASSERT_NE(intrometry::hashNames({ "a" }), intrometry::hashNames({ "a", "" }));
+    // zero is reserved for unknown fingerprints
+    ASSERT_NE(0, intrometry::hashNames({}));
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);